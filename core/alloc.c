@@ -0,0 +1,69 @@
+// alloc.c
+
+#include "core/alloc.h"
+
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+/* Atomic, so renderers on different threads can allocate concurrently */
+static size_t alloc_count = 0;
+
+#define COUNT_ALLOC() __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED)
+
+/* Allocates memory and counts the allocation */
+void* mem_alloc(size_t size) {
+	COUNT_ALLOC();
+	return malloc(size);
+}
+
+/* Resizes memory obtained from mem_alloc, counting it as an allocation */
+void* mem_realloc(void* p, size_t size) {
+	COUNT_ALLOC();
+	return realloc(p, size);
+}
+
+/* Frees memory obtained from mem_alloc */
+void mem_free(void* p) { free(p); }
+
+/* Returns the number of allocations made so far */
+size_t mem_alloc_count(void) {
+	return __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+}
+
+/*
+ * Makes room for need items of size item in *p, a mem_alloc block holding
+ * *cap of them, doubling the capacity. Returns 0 on failure, leaving *p.
+ */
+int mem_grow(void** p, int* cap, int need, size_t item) {
+	if (need <= *cap) return 1;
+	int n = *cap ? *cap : 16;
+	while (n < need) n *= 2;
+	void* q = mem_realloc(*p, (size_t) n * item);
+	if (!q) return 0;
+	*p = q;
+	*cap = n;
+	return 1;
+}
+
+/* Allocates memory aligned to align bytes (a power of two) */
+void* mem_alloc_aligned(size_t size, size_t align) {
+	COUNT_ALLOC();
+#ifdef _WIN32
+	return _aligned_malloc(size, align);
+#else
+	void* p = NULL;
+	if (posix_memalign(&p, align, size) != 0) return NULL;
+	return p;
+#endif
+}
+
+/* Frees memory obtained from mem_alloc_aligned */
+void mem_free_aligned(void* p) {
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
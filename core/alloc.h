@@ -0,0 +1,21 @@
+// alloc.h
+
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stddef.h>
+
+/*
+ * Counting wrappers around malloc/free. The animation loops compare the
+ * counter before and after each frame to prove the hot path never allocates.
+ */
+
+void* mem_alloc(size_t size);
+void* mem_realloc(void* p, size_t size);
+void mem_free(void* p);
+void* mem_alloc_aligned(size_t size, size_t align);
+void mem_free_aligned(void* p);
+size_t mem_alloc_count(void);
+int mem_grow(void** p, int* cap, int need, size_t item);
+
+#endif
@@ -0,0 +1,369 @@
+// app.c
+
+#include "core/app.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "core/alloc.h"
+#include "core/bench.h"
+#include "core/cycle.h"
+#include "core/kernels.h"
+#include "core/orient.h"
+#include "core/pipeline.h"
+#include "core/present.h"
+#include "core/record.h"
+#include "core/sched.h"
+#include "core/stats.h"
+#include "core/term.h"
+
+/* Sends the frame, or hands it to the presenting thread */
+static void send_frame(Presenter* presenter, Pipeline* pipeline,
+					   const Bench* bench, const char* frame) {
+	if (pipeline)
+		pipeline_publish(pipeline, bench->count, bench_frame_start(bench));
+	else
+		present_frame(presenter, frame);
+}
+
+/*
+ * Runs a shape program: sizes the frame to the terminal, then animates,
+ * verifies or benchmarks the scene as the options ask. Returns the exit
+ * status.
+ */
+int app_main(const Options* opts, const AppScene* scene) {
+	/* Size everything to the terminal, if the frames go to one */
+	int out_fd = options_output_fd(opts);
+	int width = SPIN_LAYOUT_WIDTH, height = SPIN_LAYOUT_HEIGHT;
+	term_size(out_fd, &width, &height);
+	term_watch_resize();
+
+	Spin spin;
+	char* cells = mem_alloc(width * height);
+	if (!cells || !spin_init(&spin, opts->threads, width, height))
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	spin.raster = opts->raster;
+	spin.cull = opts->cull;
+	spin.lod = opts->lod;
+	spin_set_light(&spin, opts->light.x, opts->light.y, opts->light.z);
+
+	/* Points are projected by the kernel asked for, if the CPU has it */
+	SimdLevel simd = simd_select(opts->simd);
+	if (simd != opts->simd)
+		fprintf(stderr, "No %s on this CPU, projecting with %s\n",
+				simd_name(opts->simd), simd_name(simd));
+	if (!scene->setup(&spin, scene->user) ||
+		(scene->fit && !scene->fit(&spin, scene->user)))
+		return 1;
+	spin_clear(&spin, cells, NULL);
+
+	/* Scheduler tick: the orientation is a pure function of it */
+	unsigned long long frame_idx = 0;
+	Scheduler sched;
+	Orienter orient;
+	int mismatches = 0, failed = 0;
+	long prepared = 0, in_view = 0; // frames composed, objects drawn in them
+
+	/* Checking a trig-free orientation mode also compares it to exact */
+	int check_orient = opts->check && opts->orient != ORIENT_EXACT;
+	char* exact_cells = NULL;
+	int orient_diffs = 0;
+	double orient_error = 0;
+
+	Presenter presenter;
+	Bench bench;
+	if (!presenter_init(&presenter, out_fd, width, height, opts->present,
+						opts->async_present) ||
+		!bench_init(&bench, opts->bench))
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	/* Main animation loop, tick 0 is due now */
+	sched_init(&sched, opts->fps, opts->sched);
+	if (!orient_init(&orient, opts->orient, scene->spin_rates,
+					 sched_tick_time(&sched, 1)) ||
+		(check_orient && !(exact_cells = mem_alloc(width * height))))
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	/* Frames are drawn into a ring that another thread sends from */
+	Pipeline pipeline;
+	Pipeline* ring = NULL;
+	if (opts->pipeline && !opts->check)
+	{
+		if (!pipeline_init(&pipeline, &presenter, &bench, width * height))
+		{
+			fprintf(stderr, "Out of memory\n");
+			return 1;
+		}
+		ring = &pipeline;
+		bench.pipelined = 1;
+	}
+
+	/* A recording keeps its first size, and ends cleanly on Ctrl+C */
+	Recorder recorder;
+	int recording = opts->record_path && !opts->check;
+	if (recording)
+	{
+		if (!recorder_open(&recorder, opts->record_path, width, height,
+						   sched.period_ns))
+			return 1;
+		term_watch_interrupt();
+	}
+
+	/* Instrumented builds log and show their counters once a second */
+	StatsLog stats;
+	int stats_on = STATS_ENABLED && (opts->stats_path || opts->stats_overlay);
+	if (stats_on && !stats_open(&stats, opts->stats_path, opts->stats_json))
+		return 1;
+
+	/*
+	 * One cycle of the rotation is rendered once, then replayed from memory.
+	 * The spin is stretched so that a cycle takes exactly one tick per step,
+	 * and a tick is drawn at its offset in the cycle: every visit of a step
+	 * shows the same orientation, so a cached frame is the live one. With
+	 * --check, each frame is compared to the one the cache holds.
+	 */
+	CycleCache cache;
+	int caching = opts->cycle_cache;
+	char* cached_cells = NULL;
+	int cache_diffs = 0;
+	if (caching)
+	{
+		int steps = opts->cycle_steps ? opts->cycle_steps
+									  : orient_cycle_ticks(&orient);
+		if (!steps)
+		{
+			fprintf(stderr, "The rotation never repeats, not caching\n");
+			caching = 0;
+		}
+		else if (!orient_set_cycle(&orient, steps) ||
+				 !cycle_init(&cache, steps, (size_t) opts->cache_mb << 20,
+							 width * height) ||
+				 (opts->check && !(cached_cells = mem_alloc(width * height))))
+		{
+			fprintf(stderr, "Out of memory\n");
+			return 1;
+		}
+	}
+
+	while (!term_interrupted())
+	{
+		/*
+		 * Follow the terminal size; only a resize touches the heap. A
+		 * recording keeps its size, and the screen is redrawn in full
+		 * whenever the terminal may have reflowed what was on it.
+		 */
+		if (term_resized())
+		{
+			int new_width, new_height;
+			term_size(out_fd, &new_width, &new_height);
+			if (recording ||
+				(new_width == spin.width && new_height == spin.height))
+			{
+				if (ring) pipeline_flush(ring);
+				presenter_invalidate(&presenter);
+			}
+			else
+			{
+				width = new_width;
+				height = new_height;
+				mem_free(cells);
+				mem_free(exact_cells);
+				mem_free(cached_cells);
+				cells = mem_alloc(width * height);
+				exact_cells = check_orient ? mem_alloc(width * height) : NULL;
+				cached_cells =
+					caching && opts->check ? mem_alloc(width * height) : NULL;
+				if (!cells || (check_orient && !exact_cells) ||
+					(caching && opts->check && !cached_cells) ||
+					!spin_resize(&spin, width, height) ||
+					(ring && !pipeline_resize(ring, width * height)) ||
+					!presenter_resize(&presenter, width, height) ||
+					(caching && !cycle_resize(&cache, width * height)) ||
+					(scene->fit && !scene->fit(&spin, scene->user)))
+				{
+					fprintf(stderr, "Out of memory\n");
+					return 1;
+				}
+			}
+		}
+
+		/* Wait for a free buffer in the ring before timing the frame */
+		char* frame = ring ? pipeline_acquire(ring) : cells;
+
+		size_t frame_allocs = mem_alloc_count();
+		bench_begin(&bench);
+
+		/* A cached step needs no 3D work at all */
+		unsigned long long tick = caching ? frame_idx % cache.steps : frame_idx;
+		int step = (int) tick;
+		if (caching && !opts->check && cycle_get(&cache, step, frame))
+		{
+			bench_lap(&bench, BENCH_TRANSFORM);
+			bench_lap(&bench, BENCH_CLEAR);
+			bench_lap(&bench, BENCH_RENDER);
+			goto store_frame;
+		}
+
+		/* Compose rotation and projection once per frame, cull faces */
+		Quat q = orient_at(&orient, tick);
+		spin_set_orientation(&spin, q);
+		spin_prepare(&spin);
+		prepared++;
+		in_view += spin.objects_drawn;
+		bench_lap(&bench, BENCH_TRANSFORM);
+
+		/* Reset buffers */
+		spin_clear(&spin, frame, NULL);
+		bench_lap(&bench, BENCH_CLEAR);
+
+		if (opts->check)
+		{
+			/* Verification mode: compare, print nothing, stop when done */
+			mismatches += !spin_verify(&spin, frame, NULL);
+			if (check_orient)
+			{
+				Quat exact = orient_exact(&orient, tick);
+				double err = quat_angle_between(q, exact);
+				if (err > orient_error) orient_error = err;
+				spin_set_orientation(&spin, exact);
+				spin_render(&spin, exact_cells, NULL);
+				orient_diffs +=
+					memcmp(frame, exact_cells, spin.width * spin.height) != 0;
+			}
+			if (caching)
+			{
+				/* A step's first visit stores it, later ones compare */
+				if (cycle_get(&cache, step, cached_cells))
+					cache_diffs += memcmp(frame, cached_cells,
+										  spin.width * spin.height) != 0;
+				else if (!cycle_put(&cache, step, frame))
+				{
+					fprintf(stderr, "Out of memory\n");
+					failed = 1;
+					break;
+				}
+			}
+			if (++frame_idx == (unsigned long long) opts->check) break;
+			continue;
+		}
+
+		/* Fill the projected faces, or splat the sampled points */
+		spin_draw(&spin, frame, NULL);
+		bench_lap(&bench, BENCH_RENDER);
+
+		/* Drawing must not have touched the heap */
+		bench_allocs(&bench, mem_alloc_count() - frame_allocs);
+		assert(mem_alloc_count() == frame_allocs);
+
+		/* After the check: storing a step allocates its encoding */
+		if (caching && !cycle_put(&cache, step, frame))
+		{
+			fprintf(stderr, "Out of memory\n");
+			failed = 1;
+			break;
+		}
+
+	store_frame:
+		/* The recording's index grows now and then */
+		if (recording && !recorder_frame(&recorder, frame, frame_idx))
+		{
+			failed = 1;
+			break;
+		}
+		bench_skip(&bench);
+
+		/* Cached and recorded without it, the overlay is only sent */
+		frame_allocs = mem_alloc_count();
+		if (stats_on && opts->stats_overlay)
+			stats_overlay(&stats, frame, spin.width);
+
+		/* Send the frame with a single write, here or from the ring */
+		send_frame(&presenter, ring, &bench, frame);
+		bench_lap(&bench, BENCH_PRESENT);
+
+		/* Sending must not touch the heap either */
+		bench_allocs(&bench, mem_alloc_count() - frame_allocs);
+		assert(mem_alloc_count() == frame_allocs);
+
+		/* Once a second the stats are logged and the overlay refreshed */
+		if (stats_on) stats_frame(&stats);
+
+		/* Benchmark mode: no pacing, stop once enough frames are timed */
+		if (opts->bench)
+		{
+			frame_idx++;
+			if (bench_end(&bench)) break;
+			continue;
+		}
+
+		/* Sleep until the next frame is due */
+		frame_idx = sched_wait(&sched);
+	}
+
+	if (opts->check)
+	{
+		printf("check: %d of %d frames differ with %d threads", mismatches,
+			   opts->check, spin.renderer.threads);
+		if (spin.raster == RASTER_POINTS)
+			printf(" and the %s kernel", simd_name(simd));
+		printf("\n");
+	}
+	if (check_orient)
+		printf("check: orientation off by at most %.3g rad, %d of %d frames "
+			   "differ from exact\n",
+			   orient_error, orient_diffs, opts->check);
+	if (caching && opts->check)
+		printf("check: %d of %d frames differ from the cycle cache of %d "
+			   "steps\n",
+			   cache_diffs, opts->check, cache.steps);
+
+	/* The writer may still hold the last frame */
+	if (ring) pipeline_free(ring);
+	presenter_flush(&presenter);
+	if (opts->bench)
+	{
+		if (spin.raster == RASTER_FACES)
+			bench_report(&bench, stdout, "triangles",
+						 spin.mesh.num_tris + scene_num_tris(&spin.objects),
+						 spin.renderer.threads, presenter_stats(&presenter));
+		else
+			bench_report(&bench, stdout, "points", spin_nominal_points(&spin),
+						 spin.renderer.threads, presenter_stats(&presenter));
+	}
+
+	if (opts->bench && spin.objects.num_objects && prepared)
+		printf("objects: %d, %.1f in view per frame\n",
+			   spin.objects.num_objects, (double) in_view / prepared);
+	if (caching)
+	{
+		if (opts->bench)
+			printf("cache: %d steps, %lu hits, %lu misses, %lu evictions, "
+				   "%zu KB\n",
+				   cache.steps, cache.hits, cache.misses, cache.evictions,
+				   cache.used >> 10);
+		cycle_free(&cache);
+	}
+	if (recording && !recorder_close(&recorder)) failed = 1;
+	if (stats_on) stats_close(&stats);
+
+	bench_free(&bench);
+	presenter_free(&presenter);
+	if (opts->sink == SINK_NULL && out_fd >= 0) close(out_fd);
+	orient_free(&orient);
+	spin_free(&spin);
+	mem_free(cells);
+	mem_free(exact_cells);
+	mem_free(cached_cells);
+	return mismatches || cache_diffs || failed ? 1 : 0;
+}
@@ -0,0 +1,23 @@
+// app.h
+
+#ifndef APP_H
+#define APP_H
+
+#include "core/linalg.h"
+#include "core/options.h"
+#include "core/spin.h"
+
+/* Structures */
+
+/* A shape program: how to build its scene and how fast it turns */
+typedef struct {
+	Vec3 spin_rates; // radians per second about x, y and z
+	int (*setup)(Spin* s, void* user);
+	int (*fit)(Spin* s, void* user); // after setup and on resize, may be NULL
+	void* user;
+} AppScene;
+
+/* Function Prototypes */
+int app_main(const Options* opts, const AppScene* scene);
+
+#endif
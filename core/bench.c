@@ -0,0 +1,159 @@
+// bench.c
+
+#include "core/bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core/alloc.h"
+
+static const char* stage_names[BENCH_STAGES] = {
+	"transform", "clear", "render", "present", "frame", "latency", "interval",
+};
+
+/* Monotonic time in seconds */
+static double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Allocates room for frames samples per stage, returns 0 on failure */
+int bench_init(Bench* b, int frames) {
+	memset(b, 0, sizeof(*b));
+	b->frames = frames;
+	if (frames == 0) return 1;
+
+	for (int s = 0; s < BENCH_STAGES; s++)
+	{
+		b->samples[s] = mem_alloc(sizeof(double) * frames);
+		if (!b->samples[s])
+		{
+			bench_free(b);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void bench_free(Bench* b) {
+	for (int s = 0; s < BENCH_STAGES; s++)
+	{
+		mem_free(b->samples[s]);
+		b->samples[s] = NULL;
+	}
+}
+
+/* Starts timing a frame */
+void bench_begin(Bench* b) {
+	if (!b->frames) return;
+	b->frame_start = b->lap_start = bench_now();
+	if (b->count == 0) b->first_start = b->frame_start;
+}
+
+/* Records the time since the previous lap as stage */
+void bench_lap(Bench* b, BenchStage stage) {
+	if (!b->frames) return;
+	double now = bench_now();
+	b->samples[stage][b->count] = now - b->lap_start;
+	b->lap_start = now;
+}
+
+/* Leaves the time since the previous lap out of every stage */
+void bench_skip(Bench* b) {
+	if (!b->frames) return;
+	b->lap_start = bench_now();
+}
+
+/* Adds allocations made by the frame where it must not allocate */
+void bench_allocs(Bench* b, size_t allocs) {
+	if (!b->frames) return;
+	b->allocs += allocs;
+}
+
+/* Finishes the frame, returns 1 once every frame has been recorded */
+int bench_end(Bench* b) {
+	if (!b->frames) return 0;
+	double now = bench_now();
+	b->samples[BENCH_FRAME][b->count] = now - b->frame_start;
+	if (!b->pipelined)
+	{
+		b->samples[BENCH_LATENCY][b->count] = now - b->frame_start;
+		b->samples[BENCH_INTERVAL][b->count] = now;
+	}
+	return ++b->count == b->frames;
+}
+
+/* Start of the frame being timed, to hand over with it */
+double bench_frame_start(const Bench* b) { return b->frame_start; }
+
+/*
+ * Records that frame, started at start, has been sent. Called in frame
+ * order by the one thread that sends them.
+ */
+void bench_sent(Bench* b, int frame, double start) {
+	if (frame < 0 || frame >= b->frames) return;
+	double now = bench_now();
+	b->samples[BENCH_LATENCY][frame] = now - start;
+	b->samples[BENCH_INTERVAL][frame] = now;
+}
+
+static int cmp_double(const void* a, const void* b) {
+	double x = *(const double*) a, y = *(const double*) b;
+	return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of n sorted samples */
+static double percentile(const double* sorted, int n, double pct) {
+	int rank = (int) (pct / 100.0 * n + 0.999999);
+	if (rank < 1) rank = 1;
+	if (rank > n) rank = n;
+	return sorted[rank - 1];
+}
+
+/* Prints min/median/p99/max per stage and the throughput in units/s */
+void bench_report(const Bench* b, FILE* out, const char* unit, long items,
+				  int threads, PresentStats present) {
+	int n = b->count;
+	if (n == 0) return;
+
+	double* sorted = mem_alloc(sizeof(double) * n);
+	if (!sorted) return;
+
+	fprintf(out, "bench: %d frames, %ld %s, %d threads\n", n, items, unit,
+			threads);
+	fprintf(out, "%-10s %10s %10s %10s %10s %10s\n", "stage (us)", "min",
+			"median", "p99", "max", "mean");
+
+	double totals[BENCH_STAGES];
+	for (int s = 0; s < BENCH_STAGES; s++)
+	{
+		memcpy(sorted, b->samples[s], sizeof(double) * n);
+
+		/* Intervals are kept as the times the frames were sent */
+		if (s == BENCH_INTERVAL)
+			for (int i = n - 1; i >= 0; i--)
+				sorted[i] -= i ? sorted[i - 1] : b->first_start;
+		qsort(sorted, n, sizeof(double), cmp_double);
+
+		totals[s] = 0;
+		for (int i = 0; i < n; i++) totals[s] += sorted[i];
+
+		fprintf(out, "%-10s %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+				stage_names[s], sorted[0] * 1e6, percentile(sorted, n, 50) * 1e6,
+				percentile(sorted, n, 99) * 1e6, sorted[n - 1] * 1e6,
+				totals[s] / n * 1e6);
+	}
+	mem_free(sorted);
+
+	double drawn = (double) items * n;
+	fprintf(out, "%s/s: %.3g rendered, %.3g end to end\n", unit,
+			totals[BENCH_RENDER] > 0 ? drawn / totals[BENCH_RENDER] : 0,
+			totals[BENCH_FRAME] > 0 ? drawn / totals[BENCH_FRAME] : 0);
+	fprintf(out, "frames/s:  %.1f\n",
+			totals[BENCH_INTERVAL] > 0 ? n / totals[BENCH_INTERVAL] : 0);
+	fprintf(out, "present:   %.2f syscalls/frame, %.0f bytes/frame\n",
+			(double) present.syscalls / n, (double) present.bytes / n);
+	fprintf(out, "allocs:    %.2f/frame\n", (double) b->allocs / n);
+}
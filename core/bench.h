@@ -0,0 +1,53 @@
+// bench.h
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+#include "core/present.h"
+
+/* Timed stages of a frame, in the order the loop runs them */
+typedef enum {
+	BENCH_TRANSFORM, // compose the matrices, cull back faces
+	BENCH_CLEAR,	 // reset the depth and screen buffers
+	BENCH_RENDER,	 // project + depth test of every point or triangle
+	BENCH_PRESENT,	 // assemble and send the frame, or hand it over
+	BENCH_FRAME,	 // the whole frame
+	BENCH_LATENCY,	 // from the frame's start until it has been sent
+	BENCH_INTERVAL,	 // between two frames being sent
+	BENCH_STAGES
+} BenchStage;
+
+/* Structures */
+
+/*
+ * Per-frame stage timings. The sample storage is allocated up front so
+ * that timing a frame never touches the heap. When frames are sent by
+ * another thread, that thread reports each one with bench_sent; otherwise
+ * a frame counts as sent when it ends.
+ */
+typedef struct {
+	int frames; // frames to record, 0 when benchmarking is off
+	int count;	// frames recorded so far
+	int pipelined; // frames are sent by bench_sent, not bench_end
+	double* samples[BENCH_STAGES];
+	double frame_start, lap_start;
+	double first_start; // of frame 0, for the intervals
+	size_t allocs; // made while drawing and sending, over all frames
+} Bench;
+
+/* Function Prototypes */
+int bench_init(Bench* b, int frames);
+void bench_free(Bench* b);
+void bench_begin(Bench* b);
+void bench_lap(Bench* b, BenchStage stage);
+void bench_skip(Bench* b);
+void bench_allocs(Bench* b, size_t allocs);
+int bench_end(Bench* b);
+double bench_frame_start(const Bench* b);
+void bench_sent(Bench* b, int frame, double start);
+void bench_report(const Bench* b, FILE* out, const char* unit, long items,
+				  int threads, PresentStats present);
+
+#endif
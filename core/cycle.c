@@ -0,0 +1,122 @@
+// cycle.c
+
+#include "core/cycle.h"
+
+#include <string.h>
+
+#include "core/alloc.h"
+#include "core/record.h"
+
+/* Starts an empty cache for frames of cells cells, 0 on failure */
+int cycle_init(CycleCache* c, int steps, size_t budget, int cells) {
+	memset(c, 0, sizeof(*c));
+	c->steps = steps;
+	c->budget = budget;
+	c->head = c->tail = -1;
+	c->entries = mem_alloc(sizeof(CycleEntry) * steps);
+	if (!c->entries) return 0;
+	for (int i = 0; i < steps; i++)
+	{
+		c->entries[i].data = NULL;
+		c->entries[i].size = 0;
+		c->entries[i].prev = c->entries[i].next = -1;
+	}
+	return cycle_resize(c, cells);
+}
+
+/* Drops every entry */
+static void cycle_clear(CycleCache* c) {
+	for (int i = 0; i < c->steps; i++)
+	{
+		mem_free(c->entries[i].data);
+		c->entries[i].data = NULL;
+		c->entries[i].prev = c->entries[i].next = -1;
+	}
+	c->head = c->tail = -1;
+	c->used = 0;
+}
+
+void cycle_free(CycleCache* c) {
+	if (c->entries) cycle_clear(c);
+	mem_free(c->entries);
+	mem_free(c->scratch);
+	c->entries = NULL;
+	c->scratch = NULL;
+}
+
+/* Drops the frames of the old size, 0 on failure */
+int cycle_resize(CycleCache* c, int cells) {
+	cycle_clear(c);
+	mem_free(c->scratch);
+	c->cells = cells;
+	c->scratch = mem_alloc(RECORD_ENCODE_MAX(cells));
+	return c->scratch != NULL;
+}
+
+static void lru_unlink(CycleCache* c, int i) {
+	CycleEntry* e = &c->entries[i];
+	if (e->prev >= 0) c->entries[e->prev].next = e->next;
+	else c->head = e->next;
+	if (e->next >= 0) c->entries[e->next].prev = e->prev;
+	else c->tail = e->prev;
+	e->prev = e->next = -1;
+}
+
+static void lru_push_front(CycleCache* c, int i) {
+	CycleEntry* e = &c->entries[i];
+	e->prev = -1;
+	e->next = c->head;
+	if (c->head >= 0) c->entries[c->head].prev = i;
+	c->head = i;
+	if (c->tail < 0) c->tail = i;
+}
+
+/* Decodes step into cells if it is cached, 1 on a hit */
+int cycle_get(CycleCache* c, int step, char* cells) {
+	CycleEntry* e = &c->entries[step];
+	if (!e->data)
+	{
+		c->misses++;
+		return 0;
+	}
+	if (!decode_key(e->data, e->data + e->size, cells, c->cells)) return 0;
+
+	if (c->head != step)
+	{
+		lru_unlink(c, step);
+		lru_push_front(c, step);
+	}
+	c->hits++;
+	return 1;
+}
+
+/* Stores the rendered frame of step, evicting to stay in budget */
+int cycle_put(CycleCache* c, int step, const char* cells) {
+	size_t size = encode_key(cells, c->cells, c->scratch) - c->scratch;
+	if (size > c->budget) return 1; // never fits: render it every time
+
+	while (c->used + size > c->budget && c->tail >= 0)
+	{
+		int old = c->tail;
+		lru_unlink(c, old);
+		c->used -= c->entries[old].size;
+		mem_free(c->entries[old].data);
+		c->entries[old].data = NULL;
+		c->evictions++;
+	}
+
+	CycleEntry* e = &c->entries[step];
+	if (e->data)
+	{
+		lru_unlink(c, step);
+		c->used -= e->size;
+		mem_free(e->data);
+	}
+	e->data = mem_alloc(size);
+	if (!e->data) return 0;
+	memcpy(e->data, c->scratch, size);
+	e->size = size;
+	c->used += size;
+	lru_push_front(c, step);
+	return 1;
+}
@@ -0,0 +1,40 @@
+// cycle.h
+
+#ifndef CYCLE_H
+#define CYCLE_H
+
+#include <stddef.h>
+
+/* Structures */
+
+/* One step of the cycle: its encoded frame and its place in the LRU list */
+typedef struct {
+	unsigned char* data; // NULL until rendered, or after eviction
+	size_t size;
+	int prev, next; // towards the most and least recently used, -1 at ends
+} CycleEntry;
+
+/*
+ * Frames of one animation cycle, split into a fixed number of steps and
+ * kept run-length encoded. When the encoded frames outgrow the budget
+ * the least recently used ones are dropped and rendered again on their
+ * next visit.
+ */
+typedef struct {
+	int steps;
+	int cells; // frame size the entries were encoded at
+	size_t budget, used;
+	CycleEntry* entries;
+	int head, tail;			// most and least recently used, -1 if empty
+	unsigned char* scratch; // encoding of the frame being stored
+	unsigned long hits, misses, evictions;
+} CycleCache;
+
+/* Function Prototypes */
+int cycle_init(CycleCache* c, int steps, size_t budget, int cells);
+void cycle_free(CycleCache* c);
+int cycle_resize(CycleCache* c, int cells);
+int cycle_get(CycleCache* c, int step, char* cells);
+int cycle_put(CycleCache* c, int step, const char* cells);
+
+#endif
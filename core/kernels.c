@@ -0,0 +1,296 @@
+// kernels.c
+
+#include "core/kernels.h"
+
+#include <pthread.h>
+
+/* The 16.16 fixed-point build only has the scalar kernel */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+	!defined(SPIN_FIXED16)
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Projection kernels: transform n points by the model-view-projection
+ * matrix, divide by w and truncate x and y to cell offsets. Every variant
+ * does the same IEEE operations in the same order (no FMA), so all of them
+ * produce bit-identical output.
+ */
+
+/*
+ * Matrix entries as the kernels read them. In fixed point they are 16.16
+ * in 64 bits: the depth row's translation, (f + n) * cz - f * n, is tens
+ * of thousands and would wrap in 32.
+ */
+#ifdef SPIN_FIXED16
+typedef int64_t MatrixEntry;
+
+static inline MatrixEntry matrix_from_double(double v) {
+	return llrint(v * (1 << REAL_FRAC_BITS));
+}
+#else
+typedef real MatrixEntry;
+
+static inline MatrixEntry matrix_from_double(double v) {
+	return real_from_double(v);
+}
+#endif
+
+typedef void (*ProjectFn)(const real* x, const real* y, const real* z, int n,
+						  const MatrixEntry m[4][4], int* sx, int* sy,
+						  real* sz);
+
+#ifdef SPIN_FIXED16
+
+/*
+ * 16.16 fixed point: the products are exact in 32.32, so clip coordinates
+ * only carry the rounding of the inputs. The quotient of two 32.32 values
+ * is the cell offset; dividing by w in 16.16 gives the depth in 16.16.
+ */
+static void project_scalar(const real* x, const real* y, const real* z, int n,
+						   const MatrixEntry m[4][4], int* sx, int* sy,
+						   real* sz) {
+	for (int i = 0; i < n; i++)
+	{
+		int64_t c[4];
+		for (int k = 0; k < 4; k++)
+			c[k] = m[k][0] * x[i] + m[k][1] * y[i] + m[k][2] * z[i] +
+				   m[k][3] * (1 << REAL_FRAC_BITS);
+
+		int64_t w16 = c[3] >> REAL_FRAC_BITS;
+		if (w16 == 0)
+		{
+			/* On the camera plane: off screen */
+			sx[i] = sy[i] = INT32_MIN / 2;
+			sz[i] = REAL_FAR;
+			continue;
+		}
+		sx[i] = (int) (c[0] / c[3]);
+		sy[i] = (int) (c[1] / c[3]);
+		sz[i] = (real) (c[2] / w16);
+	}
+}
+
+#else
+
+/* Scalar fallback, also used for the tails of the vector kernels */
+static void project_scalar(const real* x, const real* y, const real* z, int n,
+						   const MatrixEntry m[4][4], int* sx, int* sy,
+						   real* sz) {
+	for (int i = 0; i < n; i++)
+	{
+		real cx = m[0][0] * x[i] + m[0][1] * y[i] + m[0][2] * z[i] + m[0][3];
+		real cy = m[1][0] * x[i] + m[1][1] * y[i] + m[1][2] * z[i] + m[1][3];
+		real cz = m[2][0] * x[i] + m[2][1] * y[i] + m[2][2] * z[i] + m[2][3];
+		real cw = m[3][0] * x[i] + m[3][1] * y[i] + m[3][2] * z[i] + m[3][3];
+
+		sx[i] = (int) (cx / cw);
+		sy[i] = (int) (cy / cw);
+		sz[i] = cz / cw;
+	}
+}
+
+#endif
+
+#ifdef HAVE_X86_SIMD
+
+#ifdef SPIN_FLOAT32
+
+/* SSE2, four floats per iteration */
+__attribute__((target("sse2"))) static void
+project_sse2(const real* x, const real* y, const real* z, int n,
+			 const MatrixEntry m[4][4], int* sx, int* sy, real* sz) {
+	__m128 r[4][4];
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++) r[i][j] = _mm_set1_ps(m[i][j]);
+
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 px = _mm_loadu_ps(x + i);
+		__m128 py = _mm_loadu_ps(y + i);
+		__m128 pz = _mm_loadu_ps(z + i);
+		__m128 c[4];
+		for (int k = 0; k < 4; k++)
+			c[k] = _mm_add_ps(
+				_mm_add_ps(_mm_add_ps(_mm_mul_ps(r[k][0], px),
+									  _mm_mul_ps(r[k][1], py)),
+						   _mm_mul_ps(r[k][2], pz)),
+				r[k][3]);
+
+		_mm_storeu_si128((__m128i*) (sx + i),
+						 _mm_cvttps_epi32(_mm_div_ps(c[0], c[3])));
+		_mm_storeu_si128((__m128i*) (sy + i),
+						 _mm_cvttps_epi32(_mm_div_ps(c[1], c[3])));
+		_mm_storeu_ps(sz + i, _mm_div_ps(c[2], c[3]));
+	}
+	project_scalar(x + i, y + i, z + i, n - i, m, sx + i, sy + i, sz + i);
+}
+
+/* AVX2, eight floats per iteration */
+__attribute__((target("avx2"))) static void
+project_avx2(const real* x, const real* y, const real* z, int n,
+			 const MatrixEntry m[4][4], int* sx, int* sy, real* sz) {
+	__m256 r[4][4];
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++) r[i][j] = _mm256_set1_ps(m[i][j]);
+
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 px = _mm256_loadu_ps(x + i);
+		__m256 py = _mm256_loadu_ps(y + i);
+		__m256 pz = _mm256_loadu_ps(z + i);
+		__m256 c[4];
+		for (int k = 0; k < 4; k++)
+			c[k] = _mm256_add_ps(
+				_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r[k][0], px),
+											_mm256_mul_ps(r[k][1], py)),
+							  _mm256_mul_ps(r[k][2], pz)),
+				r[k][3]);
+
+		_mm256_storeu_si256((__m256i*) (sx + i),
+							_mm256_cvttps_epi32(_mm256_div_ps(c[0], c[3])));
+		_mm256_storeu_si256((__m256i*) (sy + i),
+							_mm256_cvttps_epi32(_mm256_div_ps(c[1], c[3])));
+		_mm256_storeu_ps(sz + i, _mm256_div_ps(c[2], c[3]));
+	}
+	project_scalar(x + i, y + i, z + i, n - i, m, sx + i, sy + i, sz + i);
+}
+
+#else
+
+/* SSE2, two doubles per iteration */
+__attribute__((target("sse2"))) static void
+project_sse2(const real* x, const real* y, const real* z, int n,
+			 const MatrixEntry m[4][4], int* sx, int* sy, real* sz) {
+	__m128d r[4][4];
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++) r[i][j] = _mm_set1_pd(m[i][j]);
+
+	int i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128d px = _mm_loadu_pd(x + i);
+		__m128d py = _mm_loadu_pd(y + i);
+		__m128d pz = _mm_loadu_pd(z + i);
+		__m128d c[4];
+		for (int k = 0; k < 4; k++)
+			c[k] = _mm_add_pd(
+				_mm_add_pd(_mm_add_pd(_mm_mul_pd(r[k][0], px),
+									  _mm_mul_pd(r[k][1], py)),
+						   _mm_mul_pd(r[k][2], pz)),
+				r[k][3]);
+
+		_mm_storel_epi64((__m128i*) (sx + i),
+						 _mm_cvttpd_epi32(_mm_div_pd(c[0], c[3])));
+		_mm_storel_epi64((__m128i*) (sy + i),
+						 _mm_cvttpd_epi32(_mm_div_pd(c[1], c[3])));
+		_mm_storeu_pd(sz + i, _mm_div_pd(c[2], c[3]));
+	}
+	project_scalar(x + i, y + i, z + i, n - i, m, sx + i, sy + i, sz + i);
+}
+
+/* AVX2, four doubles per iteration */
+__attribute__((target("avx2"))) static void
+project_avx2(const real* x, const real* y, const real* z, int n,
+			 const MatrixEntry m[4][4], int* sx, int* sy, real* sz) {
+	__m256d r[4][4];
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++) r[i][j] = _mm256_set1_pd(m[i][j]);
+
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d px = _mm256_loadu_pd(x + i);
+		__m256d py = _mm256_loadu_pd(y + i);
+		__m256d pz = _mm256_loadu_pd(z + i);
+		__m256d c[4];
+		for (int k = 0; k < 4; k++)
+			c[k] = _mm256_add_pd(
+				_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(r[k][0], px),
+											_mm256_mul_pd(r[k][1], py)),
+							  _mm256_mul_pd(r[k][2], pz)),
+				r[k][3]);
+
+		_mm_storeu_si128((__m128i*) (sx + i),
+						 _mm256_cvttpd_epi32(_mm256_div_pd(c[0], c[3])));
+		_mm_storeu_si128((__m128i*) (sy + i),
+						 _mm256_cvttpd_epi32(_mm256_div_pd(c[1], c[3])));
+		_mm256_storeu_pd(sz + i, _mm256_div_pd(c[2], c[3]));
+	}
+	project_scalar(x + i, y + i, z + i, n - i, m, sx + i, sy + i, sz + i);
+}
+
+#endif
+
+#endif
+
+/*
+ * The selected level is the only shared state. It is detected once and
+ * read atomically, so renderers on any thread can project concurrently.
+ */
+static SimdLevel current_level = SIMD_SCALAR;
+static pthread_once_t detect_once = PTHREAD_ONCE_INIT;
+
+/* Returns the best instruction set supported by this CPU */
+SimdLevel simd_detect(void) {
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2")) return SIMD_SSE2;
+#endif
+	return SIMD_SCALAR;
+}
+
+static void simd_detect_default(void) {
+	__atomic_store_n(&current_level, simd_detect(), __ATOMIC_RELEASE);
+}
+
+/* Selects a kernel, clamped to what the CPU supports. Returns the choice */
+SimdLevel simd_select(SimdLevel level) {
+	pthread_once(&detect_once, simd_detect_default);
+	SimdLevel best = simd_detect();
+	if (level > best) level = best;
+	__atomic_store_n(&current_level, level, __ATOMIC_RELEASE);
+	return level;
+}
+
+/* Returns the selected instruction set, detecting it on first use */
+SimdLevel simd_current(void) {
+	pthread_once(&detect_once, simd_detect_default);
+	return __atomic_load_n(&current_level, __ATOMIC_ACQUIRE);
+}
+
+/* Kernel for an instruction set */
+static ProjectFn simd_kernel(SimdLevel level) {
+#ifdef HAVE_X86_SIMD
+	if (level == SIMD_AVX2) return project_avx2;
+	if (level == SIMD_SSE2) return project_sse2;
+#endif
+	(void) level;
+	return project_scalar;
+}
+
+const char* simd_name(SimdLevel level) {
+	switch (level)
+	{
+	case SIMD_AVX2: return "avx2";
+	case SIMD_SSE2: return "sse2";
+	default: return "scalar";
+	}
+}
+
+/* Projects points [first, first + n) of pts into cell offsets and depths */
+void project_points(const PointsSoA* pts, int first, int n, const Mat4* mvp,
+					int* screen_x, int* screen_y, real* depth) {
+	ProjectFn fn = simd_kernel(simd_current());
+
+	MatrixEntry m[4][4];
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++) m[i][j] = matrix_from_double(mvp->m[i][j]);
+
+	fn(pts->x + first, pts->y + first, pts->z + first, n, m, screen_x, screen_y,
+	   depth);
+}
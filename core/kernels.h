@@ -0,0 +1,24 @@
+// kernels.h
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "core/linalg.h"
+#include "core/points.h"
+
+/* Instruction sets the projection kernel can use */
+typedef enum {
+	SIMD_SCALAR,
+	SIMD_SSE2,
+	SIMD_AVX2,
+} SimdLevel;
+
+/* Function Prototypes */
+SimdLevel simd_detect(void);
+SimdLevel simd_select(SimdLevel level);
+SimdLevel simd_current(void);
+const char* simd_name(SimdLevel level);
+void project_points(const PointsSoA* pts, int first, int n, const Mat4* mvp,
+					int* screen_x, int* screen_y, real* depth);
+
+#endif
@@ -0,0 +1,232 @@
+// linalg.h
+
+#ifndef LINALG_H
+#define LINALG_H
+
+#include <math.h>
+
+/*
+ * Fixed-size vector and matrix types. Everything here is passed and returned
+ * by value, so transforming a point never touches the heap.
+ */
+
+/* Structures */
+typedef struct {
+	double x, y, z;
+} Vec3;
+
+typedef struct {
+	double x, y, z, w;
+} Vec4;
+
+/* Rotation quaternion: w + xi + yj + zk */
+typedef struct {
+	double w, x, y, z;
+} Quat;
+
+typedef struct {
+	double m[3][3];
+} Mat3;
+
+typedef struct {
+	double m[4][4];
+} Mat4;
+
+/* Vector operations */
+static inline Vec3 vec3(double x, double y, double z) {
+	Vec3 v = {x, y, z};
+	return v;
+}
+
+static inline Vec3 vec3_add(Vec3 a, Vec3 b) {
+	return vec3(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+static inline Vec3 vec3_sub(Vec3 a, Vec3 b) {
+	return vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+static inline Vec3 vec3_scale(Vec3 a, double s) {
+	return vec3(a.x * s, a.y * s, a.z * s);
+}
+
+static inline double vec3_dot(Vec3 a, Vec3 b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline Vec3 vec3_cross(Vec3 a, Vec3 b) {
+	return vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+				a.x * b.y - a.y * b.x);
+}
+
+static inline Vec3 vec3_normalize(Vec3 a) {
+	double len = sqrt(vec3_dot(a, a));
+	return len > 0 ? vec3_scale(a, 1.0 / len) : a;
+}
+
+/* 3x3 matrix operations */
+static inline Mat3 mat3_identity(void) {
+	Mat3 r = {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
+	return r;
+}
+
+/* Matrix multiplication: result = a * b */
+static inline Mat3 mat3_mul(Mat3 a, Mat3 b) {
+	Mat3 r;
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] +
+						a.m[i][2] * b.m[2][j];
+	return r;
+}
+
+static inline Vec3 mat3_mul_vec3(const Mat3* a, Vec3 v) {
+	return vec3(a->m[0][0] * v.x + a->m[0][1] * v.y + a->m[0][2] * v.z,
+				a->m[1][0] * v.x + a->m[1][1] * v.y + a->m[1][2] * v.z,
+				a->m[2][0] * v.x + a->m[2][1] * v.y + a->m[2][2] * v.z);
+}
+
+/* Rotation around the X axis */
+static inline Mat3 mat3_rotate_x(double theta) {
+	double c = cos(theta), s = sin(theta);
+	Mat3 r = {{{1, 0, 0}, {0, c, -s}, {0, s, c}}};
+	return r;
+}
+
+/* Rotation around the Y axis */
+static inline Mat3 mat3_rotate_y(double theta) {
+	double c = cos(theta), s = sin(theta);
+	Mat3 r = {{{c, 0, s}, {0, 1, 0}, {-s, 0, c}}};
+	return r;
+}
+
+/* Rotation around the Z axis */
+static inline Mat3 mat3_rotate_z(double theta) {
+	double c = cos(theta), s = sin(theta);
+	Mat3 r = {{{c, -s, 0}, {s, c, 0}, {0, 0, 1}}};
+	return r;
+}
+
+/* Composed rotation R = Rx * (Ry * Rz), built once per frame */
+static inline Mat3 mat3_rotate_xyz(double theta_x, double theta_y,
+								   double theta_z) {
+	return mat3_mul(mat3_rotate_x(theta_x),
+					mat3_mul(mat3_rotate_y(theta_y), mat3_rotate_z(theta_z)));
+}
+
+/* Quaternion operations */
+static inline Quat quat_identity(void) {
+	Quat q = {1, 0, 0, 0};
+	return q;
+}
+
+/* Rotation of theta radians around a unit axis */
+static inline Quat quat_axis_angle(Vec3 axis, double theta) {
+	double s = sin(theta / 2);
+	Quat q = {cos(theta / 2), axis.x * s, axis.y * s, axis.z * s};
+	return q;
+}
+
+/* Hamilton product: rotating by b first, then by a */
+static inline Quat quat_mul(Quat a, Quat b) {
+	Quat q = {a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+			  a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			  a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			  a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w};
+	return q;
+}
+
+static inline Quat quat_normalize(Quat q) {
+	double len = sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+	Quat r = {q.w / len, q.x / len, q.y / len, q.z / len};
+	return r;
+}
+
+/* Same rotation as mat3_rotate_xyz, Rx * (Ry * Rz) */
+static inline Quat quat_from_euler(double theta_x, double theta_y,
+								   double theta_z) {
+	Quat qx = quat_axis_angle(vec3(1, 0, 0), theta_x);
+	Quat qy = quat_axis_angle(vec3(0, 1, 0), theta_y);
+	Quat qz = quat_axis_angle(vec3(0, 0, 1), theta_z);
+	return quat_normalize(quat_mul(qx, quat_mul(qy, qz)));
+}
+
+/* Rotation matrix of a unit quaternion */
+static inline Mat3 quat_to_mat3(Quat q) {
+	double xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	double xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	double wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+	Mat3 r = {{{1 - 2 * (yy + zz), 2 * (xy - wz), 2 * (xz + wy)},
+			   {2 * (xy + wz), 1 - 2 * (xx + zz), 2 * (yz - wx)},
+			   {2 * (xz - wy), 2 * (yz + wx), 1 - 2 * (xx + yy)}}};
+	return r;
+}
+
+/* 4x4 matrix operations */
+static inline Mat4 mat4_identity(void) {
+	Mat4 r = {{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
+	return r;
+}
+
+/* Matrix multiplication: result = a * b */
+static inline Mat4 mat4_mul(Mat4 a, Mat4 b) {
+	Mat4 r;
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] +
+						a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+	return r;
+}
+
+/* Multiplies the homogeneous point (p, 1) without dehomogenizing */
+static inline Vec4 mat4_mul_point(const Mat4* a, Vec3 p) {
+	Vec4 r;
+	r.x = a->m[0][0] * p.x + a->m[0][1] * p.y + a->m[0][2] * p.z + a->m[0][3];
+	r.y = a->m[1][0] * p.x + a->m[1][1] * p.y + a->m[1][2] * p.z + a->m[1][3];
+	r.z = a->m[2][0] * p.x + a->m[2][1] * p.y + a->m[2][2] * p.z + a->m[2][3];
+	r.w = a->m[3][0] * p.x + a->m[3][1] * p.y + a->m[3][2] * p.z + a->m[3][3];
+	return r;
+}
+
+/* Multiplies the direction (d, 0): rotation and scale, no translation */
+static inline Vec3 mat4_mul_dir(const Mat4* a, Vec3 d) {
+	return vec3(a->m[0][0] * d.x + a->m[0][1] * d.y + a->m[0][2] * d.z,
+				a->m[1][0] * d.x + a->m[1][1] * d.y + a->m[1][2] * d.z,
+				a->m[2][0] * d.x + a->m[2][1] * d.y + a->m[2][2] * d.z);
+}
+
+/* Translation matrix */
+static inline Mat4 mat4_translate(Vec3 t) {
+	Mat4 r = mat4_identity();
+	r.m[0][3] = t.x;
+	r.m[1][3] = t.y;
+	r.m[2][3] = t.z;
+	return r;
+}
+
+/* Rotation by R about the given center: T(c) * R * T(-c) */
+static inline Mat4 mat4_rotate_about(const Mat3* R, Vec3 center) {
+	Vec3 t = vec3_sub(center, mat3_mul_vec3(R, center));
+	Mat4 r = {{{R->m[0][0], R->m[0][1], R->m[0][2], t.x},
+			   {R->m[1][0], R->m[1][1], R->m[1][2], t.y},
+			   {R->m[2][0], R->m[2][1], R->m[2][2], t.z},
+			   {0, 0, 0, 1}}};
+	return r;
+}
+
+/* Scales x, y and z by the components of s */
+static inline Mat4 mat4_scale(Vec3 s) {
+	Mat4 r = {{{s.x, 0, 0, 0}, {0, s.y, 0, 0}, {0, 0, s.z, 0}, {0, 0, 0, 1}}};
+	return r;
+}
+
+/* Perspective projection matrix for the given near and far planes */
+static inline Mat4 mat4_projection(double near_dst, double far_dst) {
+	Mat4 r = {{{near_dst, 0, 0, 0},
+			   {0, near_dst, 0, 0},
+			   {0, 0, far_dst + near_dst, -far_dst * near_dst},
+			   {0, 0, 1, 0}}};
+	return r;
+}
+
+#endif
@@ -0,0 +1,131 @@
+// mesh.c
+
+#include "core/mesh.h"
+
+#include <string.h>
+
+#include "core/alloc.h"
+
+/* Allocates room for the vertices and triangles, returns 0 on failure */
+int mesh_init(Mesh* m, int num_verts, int num_tris) {
+	memset(m, 0, sizeof(*m));
+	m->num_verts = num_verts;
+	m->num_tris = num_tris;
+	m->verts = mem_alloc(sizeof(Vec3) * num_verts);
+	m->screen = mem_alloc(sizeof(Vec3) * num_verts);
+	m->tris = mem_alloc(sizeof(Triangle) * num_tris);
+	if (!m->verts || !m->screen || !m->tris)
+	{
+		mesh_free(m);
+		return 0;
+	}
+	return 1;
+}
+
+void mesh_free(Mesh* m) {
+	mem_free(m->verts);
+	mem_free(m->screen);
+	mem_free(m->tris);
+	mem_free(m->normals);
+	m->verts = m->screen = m->normals = NULL;
+	m->tris = NULL;
+	m->num_verts = m->num_tris = 0;
+}
+
+/* Stores the quad v0 v1 v2 v3 as triangles t and t + 1 */
+void mesh_set_quad(Mesh* m, int t, const int v[4], char ch) {
+	Triangle a = {{v[0], v[1], v[2]}, ch};
+	Triangle b = {{v[0], v[2], v[3]}, ch};
+	m->tris[t] = a;
+	m->tris[t + 1] = b;
+}
+
+/*
+ * Winds every triangle counter-clockwise as seen from outside, judging
+ * "outside" as away from a point inside the (convex) mesh.
+ */
+void mesh_orient_outward(Mesh* m, Vec3 inside) {
+	for (int i = 0; i < m->num_tris; i++)
+	{
+		Triangle* t = &m->tris[i];
+		Vec3 a = m->verts[t->v[0]];
+		Vec3 b = m->verts[t->v[1]];
+		Vec3 c = m->verts[t->v[2]];
+
+		Vec3 n = vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+		Vec3 centroid = vec3_scale(vec3_add(vec3_add(a, b), c), 1.0 / 3);
+		if (vec3_dot(n, vec3_sub(centroid, inside)) < 0)
+		{
+			int v = t->v[1];
+			t->v[1] = t->v[2];
+			t->v[2] = v;
+		}
+	}
+}
+
+/* Moves and scales the mesh so it fits a sphere of radius about center */
+void mesh_fit(Mesh* m, Vec3 center, double radius) {
+	if (m->num_verts == 0) return;
+
+	Vec3 lo = m->verts[0], hi = m->verts[0];
+	for (int i = 1; i < m->num_verts; i++)
+	{
+		Vec3 v = m->verts[i];
+		lo = vec3(fmin(lo.x, v.x), fmin(lo.y, v.y), fmin(lo.z, v.z));
+		hi = vec3(fmax(hi.x, v.x), fmax(hi.y, v.y), fmax(hi.z, v.z));
+	}
+	Vec3 mid = vec3_scale(vec3_add(lo, hi), 0.5);
+
+	double r2 = 0;
+	for (int i = 0; i < m->num_verts; i++)
+	{
+		Vec3 d = vec3_sub(m->verts[i], mid);
+		r2 = fmax(r2, vec3_dot(d, d));
+	}
+	double s = r2 > 0 ? radius / sqrt(r2) : 1;
+
+	for (int i = 0; i < m->num_verts; i++)
+		m->verts[i] = vec3_add(center, vec3_scale(vec3_sub(m->verts[i], mid), s));
+}
+
+/*
+ * Gives each triangle the character of the axis its normal points along
+ * most: chars holds +x, -x, +y, -y, +z, -z. Like the cube's per-face
+ * characters, these stay fixed to the model while it turns.
+ */
+void mesh_shade_by_normal(Mesh* m, const char chars[6]) {
+	for (int i = 0; i < m->num_tris; i++)
+	{
+		Triangle* t = &m->tris[i];
+		Vec3 a = m->verts[t->v[0]];
+		Vec3 n = vec3_cross(vec3_sub(m->verts[t->v[1]], a),
+							vec3_sub(m->verts[t->v[2]], a));
+
+		double ax = fabs(n.x), ay = fabs(n.y), az = fabs(n.z);
+		if (ax >= ay && ax >= az)
+			t->ch = chars[n.x >= 0 ? 0 : 1];
+		else if (ay >= az)
+			t->ch = chars[n.y >= 0 ? 2 : 3];
+		else
+			t->ch = chars[n.z >= 0 ? 4 : 5];
+	}
+}
+
+/*
+ * Stores each triangle's unit normal, along its winding (outward once
+ * mesh_orient_outward has run). Degenerate triangles get a zero normal.
+ * Returns 0 on failure.
+ */
+int mesh_compute_normals(Mesh* m) {
+	if (!m->normals) m->normals = mem_alloc(sizeof(Vec3) * m->num_tris);
+	if (!m->normals) return 0;
+
+	for (int i = 0; i < m->num_tris; i++)
+	{
+		const Triangle* t = &m->tris[i];
+		Vec3 a = m->verts[t->v[0]];
+		m->normals[i] = vec3_normalize(vec3_cross(
+			vec3_sub(m->verts[t->v[1]], a), vec3_sub(m->verts[t->v[2]], a)));
+	}
+	return 1;
+}
@@ -0,0 +1,41 @@
+// mesh.h
+
+#ifndef MESH_H
+#define MESH_H
+
+#include "core/linalg.h"
+
+/* Structures */
+
+/* A face triangle: three vertex indices and the character it is drawn with */
+typedef struct {
+	int v[3];
+	char ch;
+} Triangle;
+
+/*
+ * Indexed triangle mesh. screen holds the projected vertices of the
+ * current frame, so projecting never allocates. With cull set, triangles
+ * facing away from the camera are skipped; this needs the outward
+ * winding that mesh_orient_outward establishes.
+ */
+typedef struct {
+	Vec3* verts;
+	Vec3* screen;
+	int num_verts;
+	Triangle* tris;
+	int num_tris;
+	Vec3* normals; // unit triangle normals for lighting, NULL until needed
+	int cull;
+} Mesh;
+
+/* Function Prototypes */
+int mesh_init(Mesh* m, int num_verts, int num_tris);
+void mesh_free(Mesh* m);
+void mesh_set_quad(Mesh* m, int t, const int v[4], char ch);
+void mesh_orient_outward(Mesh* m, Vec3 inside);
+void mesh_fit(Mesh* m, Vec3 center, double radius);
+void mesh_shade_by_normal(Mesh* m, const char chars[6]);
+int mesh_compute_normals(Mesh* m);
+
+#endif
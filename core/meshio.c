@@ -0,0 +1,558 @@
+// meshio.c
+
+#include "core/meshio.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+#include "core/alloc.h"
+
+/*
+ * Wavefront OBJ and PLY loading. Files are parsed as a stream, a line or
+ * a record at a time, so the text is never held in memory. The parsed
+ * geometry is stored next to the source as <path>.spincache and reused
+ * while the source keeps the same size and modification time.
+ *
+ * Both formats are y-up with the camera looking down -z; the renderer is
+ * y-down looking down +z, so y and z are negated on load. That is a
+ * rotation, so the files' counter-clockwise front faces stay outward.
+ */
+
+#define LINE_MAX_LEN 4096
+
+/* Cache file layout, all in host byte order */
+#define CACHE_MAGIC "SPINMSH1"
+#define CACHE_BOM 0x01020304u
+
+typedef struct {
+	char magic[8];
+	uint32_t bom;
+	uint32_t num_verts, num_tris;
+	uint32_t reserved;
+	int64_t src_size, src_mtime;
+} CacheHeader;
+
+/* Growable vertex and triangle arrays filled by the parsers */
+typedef struct {
+	float* verts; // x, y, z per vertex
+	int num_verts, cap_verts;
+	uint32_t* tris; // three indices per triangle
+	int num_tris, cap_tris;
+} Builder;
+
+static int add_vertex(Builder* b, double x, double y, double z) {
+	if (!mem_grow((void**) &b->verts, &b->cap_verts, b->num_verts + 1,
+				  3 * sizeof(float)))
+		return 0;
+	float* v = b->verts + 3 * b->num_verts++;
+	v[0] = (float) x;
+	v[1] = (float) -y;
+	v[2] = (float) -z;
+	return 1;
+}
+
+static int add_triangle(Builder* b, uint32_t i0, uint32_t i1, uint32_t i2) {
+	if (!mem_grow((void**) &b->tris, &b->cap_tris, b->num_tris + 1,
+				  3 * sizeof(uint32_t)))
+		return 0;
+	uint32_t* t = b->tris + 3 * b->num_tris++;
+	t[0] = i0;
+	t[1] = i1;
+	t[2] = i2;
+	return 1;
+}
+
+static void builder_free(Builder* b) {
+	mem_free(b->verts);
+	mem_free(b->tris);
+	memset(b, 0, sizeof(*b));
+}
+
+/* OBJ */
+
+/*
+ * Parses one "f" statement: each vertex is "v", "v/vt", "v//vn" or
+ * "v/vt/vn", with negative indices counting back from the last vertex.
+ * Polygons are split into a fan of triangles.
+ */
+static int obj_face(Builder* b, char* s, const char* path, long lineno) {
+	long first = -1, prev = -1;
+	int n = 0;
+
+	while (1)
+	{
+		while (isspace((unsigned char) *s)) s++;
+		if (*s == '\0' || *s == '#') break;
+
+		char* end;
+		long idx = strtol(s, &end, 10);
+		if (end == s || idx == 0)
+		{
+			fprintf(stderr, "%s:%ld: bad face index\n", path, lineno);
+			return 0;
+		}
+		idx = idx < 0 ? b->num_verts + idx : idx - 1;
+		if (idx < 0 || idx >= b->num_verts)
+		{
+			fprintf(stderr, "%s:%ld: face index out of range\n", path, lineno);
+			return 0;
+		}
+
+		/* Skip the texture and normal indices */
+		s = end;
+		while (*s && !isspace((unsigned char) *s)) s++;
+
+		if (n == 0)
+			first = idx;
+		else if (n >= 2 && !add_triangle(b, (uint32_t) first, (uint32_t) prev,
+										  (uint32_t) idx))
+			return 0;
+		prev = idx;
+		n++;
+	}
+
+	if (n < 3)
+	{
+		fprintf(stderr, "%s:%ld: face with fewer than 3 vertices\n", path,
+				lineno);
+		return 0;
+	}
+	return 1;
+}
+
+static int load_obj(Builder* b, FILE* f, const char* path) {
+	char line[LINE_MAX_LEN];
+	long lineno = 0;
+
+	while (fgets(line, sizeof(line), f))
+	{
+		lineno++;
+		size_t len = strlen(line);
+		if (len == sizeof(line) - 1 && line[len - 1] != '\n' && !feof(f))
+		{
+			fprintf(stderr, "%s:%ld: line too long\n", path, lineno);
+			return 0;
+		}
+
+		char* s = line;
+		while (isspace((unsigned char) *s)) s++;
+
+		if (s[0] == 'v' && isspace((unsigned char) s[1]))
+		{
+			double xyz[3];
+			char* p = s + 1;
+			for (int k = 0; k < 3; k++)
+			{
+				char* end;
+				xyz[k] = strtod(p, &end);
+				if (end == p)
+				{
+					fprintf(stderr, "%s:%ld: bad vertex\n", path, lineno);
+					return 0;
+				}
+				p = end;
+			}
+			if (!add_vertex(b, xyz[0], xyz[1], xyz[2])) return 0;
+		}
+		else if (s[0] == 'f' && isspace((unsigned char) s[1]))
+		{
+			if (!obj_face(b, s + 1, path, lineno)) return 0;
+		}
+	}
+	return !ferror(f);
+}
+
+/* PLY */
+
+typedef enum {
+	PLY_INT8,
+	PLY_UINT8,
+	PLY_INT16,
+	PLY_UINT16,
+	PLY_INT32,
+	PLY_UINT32,
+	PLY_FLOAT32,
+	PLY_FLOAT64,
+} PlyType;
+
+typedef enum {
+	PLY_ASCII,
+	PLY_LITTLE,
+	PLY_BIG,
+} PlyFormat;
+
+#define PLY_MAX_PROPS 32
+#define PLY_MAX_ELEMENTS 16
+
+typedef struct {
+	PlyType type;
+	int is_list;
+	PlyType count_type;
+	int role; // 0 ignored, 1..3 x/y/z, 4 vertex indices
+} PlyProp;
+
+typedef struct {
+	int is_vertex, is_face;
+	long count;
+	PlyProp props[PLY_MAX_PROPS];
+	int num_props;
+} PlyElement;
+
+static int ply_type(const char* name, PlyType* t) {
+	static const struct {
+		const char* name;
+		PlyType type;
+	} names[] = {
+		{"char", PLY_INT8},		 {"int8", PLY_INT8},
+		{"uchar", PLY_UINT8},	 {"uint8", PLY_UINT8},
+		{"short", PLY_INT16},	 {"int16", PLY_INT16},
+		{"ushort", PLY_UINT16},	 {"uint16", PLY_UINT16},
+		{"int", PLY_INT32},		 {"int32", PLY_INT32},
+		{"uint", PLY_UINT32},	 {"uint32", PLY_UINT32},
+		{"float", PLY_FLOAT32},	 {"float32", PLY_FLOAT32},
+		{"double", PLY_FLOAT64}, {"float64", PLY_FLOAT64},
+	};
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+		if (strcmp(name, names[i].name) == 0)
+		{
+			*t = names[i].type;
+			return 1;
+		}
+	return 0;
+}
+
+/* Reads one value of type t, returns 0 at end of file or on bad input */
+static int ply_read(FILE* f, PlyFormat fmt, PlyType t, double* out) {
+	static const int sizes[] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+	if (fmt == PLY_ASCII) return fscanf(f, "%lf", out) == 1;
+
+	unsigned char raw[8];
+	int size = sizes[t];
+	if (fread(raw, 1, size, f) != (size_t) size) return 0;
+
+	/* Put the bytes in host order */
+	const uint16_t probe = 1;
+	int host_little = *(const unsigned char*) &probe == 1;
+	if (host_little != (fmt == PLY_LITTLE))
+		for (int i = 0; i < size / 2; i++)
+		{
+			unsigned char c = raw[i];
+			raw[i] = raw[size - 1 - i];
+			raw[size - 1 - i] = c;
+		}
+
+	switch (t)
+	{
+	case PLY_INT8: *out = (int8_t) raw[0]; break;
+	case PLY_UINT8: *out = raw[0]; break;
+	case PLY_INT16: { int16_t v; memcpy(&v, raw, 2); *out = v; } break;
+	case PLY_UINT16: { uint16_t v; memcpy(&v, raw, 2); *out = v; } break;
+	case PLY_INT32: { int32_t v; memcpy(&v, raw, 4); *out = v; } break;
+	case PLY_UINT32: { uint32_t v; memcpy(&v, raw, 4); *out = v; } break;
+	case PLY_FLOAT32: { float v; memcpy(&v, raw, 4); *out = v; } break;
+	case PLY_FLOAT64: memcpy(out, raw, 8); break;
+	}
+	return 1;
+}
+
+/* Parses the header up to and including end_header */
+static int ply_header(FILE* f, const char* path, PlyFormat* fmt,
+					  PlyElement* elems, int* num_elems) {
+	char line[LINE_MAX_LEN];
+	char a[64], b[64], c[64], d[64];
+	PlyElement* cur = NULL;
+	*num_elems = 0;
+
+	if (!fgets(line, sizeof(line), f) || strncmp(line, "ply", 3) != 0)
+	{
+		fprintf(stderr, "%s: not a PLY file\n", path);
+		return 0;
+	}
+
+	while (fgets(line, sizeof(line), f))
+	{
+		int n = sscanf(line, "%63s %63s %63s %63s", a, b, c, d);
+		if (n < 1 || strcmp(a, "comment") == 0 || strcmp(a, "obj_info") == 0)
+			continue;
+
+		if (strcmp(a, "end_header") == 0) return 1;
+
+		if (strcmp(a, "format") == 0 && n >= 2)
+		{
+			if (strcmp(b, "ascii") == 0)
+				*fmt = PLY_ASCII;
+			else if (strcmp(b, "binary_little_endian") == 0)
+				*fmt = PLY_LITTLE;
+			else if (strcmp(b, "binary_big_endian") == 0)
+				*fmt = PLY_BIG;
+			else
+				break;
+		}
+		else if (strcmp(a, "element") == 0 && n >= 3)
+		{
+			if (*num_elems == PLY_MAX_ELEMENTS) break;
+			cur = &elems[(*num_elems)++];
+			memset(cur, 0, sizeof(*cur));
+			cur->is_vertex = strcmp(b, "vertex") == 0;
+			cur->is_face = strcmp(b, "face") == 0;
+			cur->count = strtol(c, NULL, 10);
+			if (cur->count < 0) break;
+		}
+		else if (strcmp(a, "property") == 0 && cur && n >= 3)
+		{
+			if (cur->num_props == PLY_MAX_PROPS) break;
+			PlyProp* p = &cur->props[cur->num_props++];
+			memset(p, 0, sizeof(*p));
+
+			if (strcmp(b, "list") == 0)
+			{
+				if (n < 4 || !ply_type(c, &p->count_type) || !ply_type(d, &p->type))
+					break;
+				p->is_list = 1;
+
+				/* property list <count type> <index type> <name> */
+				char name[64];
+				if (cur->is_face &&
+					sscanf(line, "%*s %*s %*s %*s %63s", name) == 1 &&
+					(strcmp(name, "vertex_indices") == 0 ||
+					 strcmp(name, "vertex_index") == 0))
+					p->role = 4;
+			}
+			else
+			{
+				if (!ply_type(b, &p->type)) break;
+				if (cur->is_vertex && strlen(c) == 1 && c[0] >= 'x' && c[0] <= 'z')
+					p->role = 1 + c[0] - 'x';
+			}
+		}
+		else
+			break;
+	}
+
+	fprintf(stderr, "%s: unsupported PLY header line: %s", path, line);
+	return 0;
+}
+
+static int load_ply(Builder* b, FILE* f, const char* path) {
+	PlyFormat fmt = PLY_ASCII;
+	PlyElement elems[PLY_MAX_ELEMENTS];
+	int num_elems;
+	if (!ply_header(f, path, &fmt, elems, &num_elems)) return 0;
+
+	for (int e = 0; e < num_elems; e++)
+	{
+		PlyElement* el = &elems[e];
+		for (long i = 0; i < el->count; i++)
+		{
+			double xyz[3] = {0, 0, 0};
+
+			for (int k = 0; k < el->num_props; k++)
+			{
+				PlyProp* p = &el->props[k];
+				double v;
+
+				if (!p->is_list)
+				{
+					if (!ply_read(f, fmt, p->type, &v)) goto truncated;
+					if (p->role >= 1 && p->role <= 3) xyz[p->role - 1] = v;
+					continue;
+				}
+
+				double count;
+				if (!ply_read(f, fmt, p->count_type, &count) || count < 0)
+					goto truncated;
+
+				/* Fan-triangulate vertex index lists, skip any other list */
+				long first = -1, prev = -1;
+				for (long j = 0; j < (long) count; j++)
+				{
+					if (!ply_read(f, fmt, p->type, &v)) goto truncated;
+					if (p->role != 4) continue;
+
+					long idx = (long) v;
+					if (idx < 0 || idx >= b->num_verts)
+					{
+						fprintf(stderr, "%s: face %ld: index out of range\n",
+								path, i);
+						return 0;
+					}
+					if (j == 0)
+						first = idx;
+					else if (j >= 2 && !add_triangle(b, (uint32_t) first,
+													  (uint32_t) prev,
+													  (uint32_t) idx))
+						return 0;
+					prev = idx;
+				}
+			}
+
+			if (el->is_vertex && !add_vertex(b, xyz[0], xyz[1], xyz[2]))
+				return 0;
+		}
+	}
+	return 1;
+
+truncated:
+	fprintf(stderr, "%s: truncated or malformed PLY data\n", path);
+	return 0;
+}
+
+/* Cache */
+
+static char* cache_path(const char* path) {
+	static const char suffix[] = ".spincache";
+	size_t len = strlen(path);
+	char* p = mem_alloc(len + sizeof(suffix));
+	if (!p) return NULL;
+	memcpy(p, path, len);
+	memcpy(p + len, suffix, sizeof(suffix));
+	return p;
+}
+
+/* Loads the cache if it matches the source, returns 0 if unusable */
+static int cache_read(Builder* b, const char* cpath, const struct stat* src) {
+	FILE* f = fopen(cpath, "rb");
+	if (!f) return 0;
+
+	CacheHeader h;
+	int ok = fread(&h, sizeof(h), 1, f) == 1 &&
+			 memcmp(h.magic, CACHE_MAGIC, 8) == 0 && h.bom == CACHE_BOM &&
+			 h.src_size == (int64_t) src->st_size &&
+			 h.src_mtime == (int64_t) src->st_mtime && h.num_verts < INT32_MAX &&
+			 h.num_tris < INT32_MAX;
+
+	if (ok)
+	{
+		b->verts = mem_alloc((size_t) h.num_verts * 3 * sizeof(float) + 1);
+		b->tris = mem_alloc((size_t) h.num_tris * 3 * sizeof(uint32_t) + 1);
+		b->num_verts = b->cap_verts = (int) h.num_verts;
+		b->num_tris = b->cap_tris = (int) h.num_tris;
+		ok = b->verts && b->tris &&
+			 fread(b->verts, 3 * sizeof(float), h.num_verts, f) == h.num_verts &&
+			 fread(b->tris, 3 * sizeof(uint32_t), h.num_tris, f) == h.num_tris;
+		for (int i = 0; ok && i < 3 * b->num_tris; i++)
+			ok = b->tris[i] < h.num_verts;
+	}
+	fclose(f);
+
+	if (!ok) builder_free(b);
+	return ok;
+}
+
+/* Writes the cache through a temporary file; failures are not fatal */
+static void cache_write(const Builder* b, const char* cpath,
+						const struct stat* src) {
+	size_t len = strlen(cpath);
+	char* tmp = mem_alloc(len + 5);
+	if (!tmp) return;
+	memcpy(tmp, cpath, len);
+	memcpy(tmp + len, ".tmp", 5);
+
+	CacheHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, CACHE_MAGIC, 8);
+	h.bom = CACHE_BOM;
+	h.num_verts = (uint32_t) b->num_verts;
+	h.num_tris = (uint32_t) b->num_tris;
+	h.src_size = (int64_t) src->st_size;
+	h.src_mtime = (int64_t) src->st_mtime;
+
+	FILE* f = fopen(tmp, "wb");
+	if (f)
+	{
+		int ok =
+			fwrite(&h, sizeof(h), 1, f) == 1 &&
+			fwrite(b->verts, 3 * sizeof(float), b->num_verts, f) ==
+				(size_t) b->num_verts &&
+			fwrite(b->tris, 3 * sizeof(uint32_t), b->num_tris, f) ==
+				(size_t) b->num_tris;
+		ok = fclose(f) == 0 && ok;
+		if (!ok || rename(tmp, cpath) != 0) remove(tmp);
+	}
+	mem_free(tmp);
+}
+
+/* Loading */
+
+static int has_suffix(const char* s, const char* suffix) {
+	size_t n = strlen(s), k = strlen(suffix);
+	return n >= k && strcasecmp(s + n - k, suffix) == 0;
+}
+
+static int parse_file(Builder* b, const char* path) {
+	FILE* f = fopen(path, "rb");
+	if (!f)
+	{
+		perror(path);
+		return 0;
+	}
+
+	/* PLY files announce themselves, anything else is read as OBJ */
+	char magic[4] = {0};
+	size_t got = fread(magic, 1, 3, f);
+	rewind(f);
+	int ply = has_suffix(path, ".ply") ||
+			  (got == 3 && memcmp(magic, "ply", 3) == 0);
+
+	int ok = ply ? load_ply(b, f, path) : load_obj(b, f, path);
+	fclose(f);
+	return ok;
+}
+
+/*
+ * Loads an OBJ or PLY file into m, triangulating polygons. Triangle
+ * characters are left for the caller to assign. Returns 0 on failure.
+ */
+int mesh_load(Mesh* m, const char* path, int use_cache) {
+	struct stat st;
+	if (stat(path, &st) != 0)
+	{
+		perror(path);
+		return 0;
+	}
+
+	Builder b;
+	memset(&b, 0, sizeof(b));
+	char* cpath = use_cache ? cache_path(path) : NULL;
+
+	int ok = cpath && cache_read(&b, cpath, &st);
+	if (!ok)
+	{
+		ok = parse_file(&b, path);
+		if (ok && cpath) cache_write(&b, cpath, &st);
+	}
+	mem_free(cpath);
+
+	if (ok && b.num_tris == 0)
+	{
+		fprintf(stderr, "%s: no faces\n", path);
+		ok = 0;
+	}
+	if (ok && !mesh_init(m, b.num_verts, b.num_tris))
+	{
+		fprintf(stderr, "Out of memory\n");
+		ok = 0;
+	}
+
+	if (ok)
+	{
+		for (int i = 0; i < b.num_verts; i++)
+			m->verts[i] = vec3(b.verts[3 * i], b.verts[3 * i + 1],
+							   b.verts[3 * i + 2]);
+		for (int i = 0; i < b.num_tris; i++)
+		{
+			Triangle t = {{(int) b.tris[3 * i], (int) b.tris[3 * i + 1],
+						   (int) b.tris[3 * i + 2]},
+						  ' '};
+			m->tris[i] = t;
+		}
+	}
+	builder_free(&b);
+	return ok;
+}
@@ -0,0 +1,11 @@
+// meshio.h
+
+#ifndef MESHIO_H
+#define MESHIO_H
+
+#include "core/mesh.h"
+
+/* Function Prototypes */
+int mesh_load(Mesh* m, const char* path, int use_cache);
+
+#endif
@@ -0,0 +1,266 @@
+// options.c
+
+#include "core/options.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "core/stats.h"
+
+static void usage(const char* prog) {
+	fprintf(stderr,
+			"Usage: %s [options]\n"
+			"  --threads N   render with N threads (0 = one per CPU)\n"
+			"  --check N     verify N frames of the threaded renderer against\n"
+			"                the single-threaded one and exit\n"
+			"  --present M   send changed cells (diff, default) or every\n"
+			"                cell (full) to the terminal\n"
+			"  --async-present\n"
+			"                write each frame from a separate thread\n"
+			"  --pipeline    render the next frame while another thread\n"
+			"                assembles and sends this one\n"
+			"  --bench N     render N frames without sleeping and print\n"
+			"                per-stage timings\n"
+			"  --sink S      send frames to the terminal (tty, default),\n"
+			"                /dev/null (null) or nowhere (mem)\n"
+			"  --fps F       target frame rate (default 12.5)\n"
+			"  --sched P     on a missed deadline drop the late frames (skip,\n"
+			"                default) or render them back to back (catchup)\n"
+			"  --orient O    compute each orientation with sin/cos (exact,\n"
+			"                default), by a fixed per-tick rotation (step)\n"
+			"                or from a table of quantised angles (table)\n"
+			"  --raster R    fill the faces (faces, default) or draw points\n"
+			"                sampled on them (points)\n"
+			"  --simd K      project points with the scalar, sse2 or avx2\n"
+			"                kernel (default: the best the CPU supports)\n"
+			"  --no-cull     draw back faces too\n"
+			"  --no-lod      sample points at one density, whatever the\n"
+			"                faces' size on screen\n"
+			"  --light X,Y,Z shade faces by their lighting from direction\n"
+			"                X,Y,Z (y down, -z towards the viewer)\n"
+			"  --mesh FILE   OBJ or PLY file to draw (model only), or to add\n"
+			"                to the wall's shapes (wall only)\n"
+			"  --objects N   objects on the wall (wall only)\n"
+			"  --no-cache    always parse the mesh file, never write its cache\n"
+			"  --record FILE write the frames shown to FILE\n"
+			"  --replay FILE recording to play (play only)\n"
+			"  --loop        play the recording again when it ends\n"
+			"  --from N      start playing at frame N (play only)\n"
+			"  --cycle-cache render each frame of the rotation cycle once,\n"
+			"                then serve it from memory\n"
+			"  --cycle-steps N\n"
+			"                play the cycle in N frames (default: as many\n"
+			"                ticks as it takes, rounded)\n"
+			"  --cache-mb M  memory for cached frames (default 64), least\n"
+			"                recently used frames are dropped beyond it\n"
+			"  --stats-log FILE\n"
+			"                write stage times and counters per frame to\n"
+			"                FILE as CSV, once a second (make STATS=1)\n"
+			"  --stats-json  write the stats log as JSON lines\n"
+			"  --stats-overlay\n"
+			"                show the stats on the top row (make STATS=1)\n",
+			prog);
+}
+
+/* Parses a non-negative integer argument, returns -1 if invalid */
+static int parse_count(const char* s) {
+	char* end;
+	long v = strtol(s, &end, 10);
+	if (*s == '\0' || *end != '\0' || v < 0 || v > 1 << 20) return -1;
+	return (int) v;
+}
+
+/* Parses a frame rate in (0, 1000], returns -1 if invalid */
+static double parse_rate(const char* s) {
+	char* end;
+	double v = strtod(s, &end);
+	if (*s == '\0' || *end != '\0' || !(v > 0 && v <= 1000)) return -1;
+	return v;
+}
+
+/* Maps a --sink name to its OutputSink, returns -1 if unknown */
+static int parse_sink(const char* s) {
+	if (strcmp(s, "tty") == 0) return SINK_TTY;
+	if (strcmp(s, "null") == 0) return SINK_NULL;
+	if (strcmp(s, "mem") == 0) return SINK_MEM;
+	return -1;
+}
+
+/* Maps an --orient name to its OrientMode, returns -1 if unknown */
+static int parse_orient(const char* s) {
+	if (strcmp(s, "exact") == 0) return ORIENT_EXACT;
+	if (strcmp(s, "step") == 0) return ORIENT_STEP;
+	if (strcmp(s, "table") == 0) return ORIENT_TABLE;
+	return -1;
+}
+
+/* Maps a --simd name to its SimdLevel, returns -1 if unknown */
+static int parse_simd(const char* s) {
+	if (strcmp(s, "scalar") == 0) return SIMD_SCALAR;
+	if (strcmp(s, "sse2") == 0) return SIMD_SSE2;
+	if (strcmp(s, "avx2") == 0) return SIMD_AVX2;
+	return -1;
+}
+
+/* Parses a non-zero X,Y,Z direction into v, returns 0 if invalid */
+static int parse_dir(const char* s, Vec3* v) {
+	double c[3];
+	char* end;
+	for (int i = 0; i < 3; i++)
+	{
+		c[i] = strtod(s, &end);
+		if (end == s || *end != (i < 2 ? ',' : '\0')) return 0;
+		s = end + 1;
+	}
+	*v = vec3(c[0], c[1], c[2]);
+	return vec3_dot(*v, *v) > 0;
+}
+
+/* Fills o from the command line, returns 0 after printing usage on error */
+int options_parse(Options* o, int argc, char** argv) {
+	o->threads = 1;
+	o->check = 0;
+	o->present = PRESENT_DIFF;
+	o->async_present = 0;
+	o->pipeline = 0;
+	o->bench = 0;
+	o->sink = SINK_TTY;
+	o->fps = 12.5;
+	o->sched = SCHED_SKIP;
+	o->orient = ORIENT_EXACT;
+	o->raster = RASTER_FACES;
+	o->cull = 1;
+	o->lod = 1;
+	o->simd = simd_detect();
+	o->light = vec3(0, 0, 0);
+	o->mesh_path = NULL;
+	o->mesh_cache = 1;
+	o->objects = 0;
+	o->record_path = NULL;
+	o->replay_path = NULL;
+	o->loop = 0;
+	o->replay_from = 0;
+	o->cycle_cache = 0;
+	o->cycle_steps = 0;
+	o->cache_mb = 64;
+	o->stats_path = NULL;
+	o->stats_json = 0;
+	o->stats_overlay = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* val = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (strcmp(arg, "--threads") == 0 && val)
+			o->threads = parse_count(argv[++i]);
+		else if (strcmp(arg, "--check") == 0 && val)
+			o->check = parse_count(argv[++i]);
+		else if (strcmp(arg, "--present") == 0 && val &&
+				 (strcmp(val, "diff") == 0 || strcmp(val, "full") == 0))
+			o->present = strcmp(argv[++i], "full") == 0 ? PRESENT_FULL
+														: PRESENT_DIFF;
+		else if (strcmp(arg, "--async-present") == 0)
+			o->async_present = 1;
+		else if (strcmp(arg, "--pipeline") == 0)
+			o->pipeline = 1;
+		else if (strcmp(arg, "--bench") == 0 && val)
+			o->bench = parse_count(argv[++i]);
+		else if (strcmp(arg, "--sink") == 0 && val && parse_sink(val) >= 0)
+			o->sink = parse_sink(argv[++i]);
+		else if (strcmp(arg, "--fps") == 0 && val)
+			o->fps = parse_rate(argv[++i]);
+		else if (strcmp(arg, "--sched") == 0 && val &&
+				 (strcmp(val, "skip") == 0 || strcmp(val, "catchup") == 0))
+			o->sched = strcmp(argv[++i], "catchup") == 0 ? SCHED_CATCHUP
+														 : SCHED_SKIP;
+		else if (strcmp(arg, "--orient") == 0 && val && parse_orient(val) >= 0)
+			o->orient = parse_orient(argv[++i]);
+		else if (strcmp(arg, "--no-cull") == 0)
+			o->cull = 0;
+		else if (strcmp(arg, "--no-lod") == 0)
+			o->lod = 0;
+		else if (strcmp(arg, "--light") == 0 && val &&
+				 parse_dir(val, &o->light))
+			i++;
+		else if (strcmp(arg, "--mesh") == 0 && val)
+			o->mesh_path = argv[++i];
+		else if (strcmp(arg, "--objects") == 0 && val)
+			o->objects = parse_count(argv[++i]);
+		else if (strcmp(arg, "--no-cache") == 0)
+			o->mesh_cache = 0;
+		else if (strcmp(arg, "--record") == 0 && val)
+			o->record_path = argv[++i];
+		else if (strcmp(arg, "--replay") == 0 && val)
+			o->replay_path = argv[++i];
+		else if (strcmp(arg, "--loop") == 0)
+			o->loop = 1;
+		else if (strcmp(arg, "--from") == 0 && val)
+			o->replay_from = parse_count(argv[++i]);
+		else if (strcmp(arg, "--cycle-cache") == 0)
+			o->cycle_cache = 1;
+		else if (strcmp(arg, "--cycle-steps") == 0 && val)
+			o->cycle_cache = 1, o->cycle_steps = parse_count(argv[++i]);
+		else if (strcmp(arg, "--cache-mb") == 0 && val)
+			o->cache_mb = parse_count(argv[++i]);
+		else if (strcmp(arg, "--stats-log") == 0 && val)
+			o->stats_path = argv[++i];
+		else if (strcmp(arg, "--stats-json") == 0)
+			o->stats_json = 1;
+		else if (strcmp(arg, "--stats-overlay") == 0)
+			o->stats_overlay = 1;
+		else if (strcmp(arg, "--simd") == 0 && val && parse_simd(val) >= 0)
+			o->simd = parse_simd(argv[++i]);
+		else if (strcmp(arg, "--raster") == 0 && val &&
+				 (strcmp(val, "faces") == 0 || strcmp(val, "points") == 0))
+			o->raster = strcmp(argv[++i], "points") == 0 ? RASTER_POINTS
+														 : RASTER_FACES;
+		else
+		{
+			usage(argv[0]);
+			return 0;
+		}
+
+		if (o->threads < 0 || o->check < 0 || o->bench < 0 ||
+			o->fps < 0 || o->cycle_steps < 0 || o->cache_mb < 0 ||
+			o->objects < 0 || o->replay_from < 0)
+		{
+			usage(argv[0]);
+			return 0;
+		}
+	}
+
+	/* The counters only exist in instrumented builds */
+	if (!STATS_ENABLED && (o->stats_path || o->stats_overlay))
+	{
+		fprintf(stderr, "%s: stats need a build with make STATS=1\n",
+				argv[0]);
+		return 0;
+	}
+
+	if (o->threads == 0)
+	{
+		long cpus = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+		o->threads = cpus > 0 ? (int) cpus : 1;
+	}
+
+	/* Verifying a single thread against itself proves nothing */
+	if (o->check && o->threads == 1) o->threads = 4;
+	return 1;
+}
+
+/* Opens the selected sink; -1 means compose only (see Presenter) */
+int options_output_fd(const Options* o) {
+	if (o->sink == SINK_TTY) return STDOUT_FILENO;
+	if (o->sink == SINK_MEM) return -1;
+
+	int fd = open("/dev/null", O_WRONLY);
+	if (fd < 0) fprintf(stderr, "Cannot open /dev/null, using --sink mem\n");
+	return fd;
+}
@@ -0,0 +1,57 @@
+// options.h
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "core/kernels.h"
+#include "core/orient.h"
+#include "core/present.h"
+#include "core/sched.h"
+#include "core/spin.h"
+
+/* Where frames are sent */
+typedef enum {
+	SINK_TTY,  // standard output
+	SINK_NULL, // /dev/null, keeps the write() cost
+	SINK_MEM,  // nowhere, frames are only composed
+} OutputSink;
+
+/* Structures */
+
+/* Command line options shared by the shape programs */
+typedef struct {
+	int threads; // render threads, 0 picks one per online CPU
+	int check;	 // frames to verify against the single-threaded path
+	PresentMode present;
+	int async_present; // write frame N while composing frame N + 1
+	int pipeline;	   // present frame N while rendering frame N + 1
+	int bench;		   // frames to time without sleeping, then report
+	OutputSink sink;
+	double fps; // target frame rate of the animation
+	SchedPolicy sched;
+	OrientMode orient;
+	RasterMode raster;
+	int cull; // skip faces turned away from the camera
+	int lod;  // sample faces by their size on screen
+	SimdLevel simd; // point projection kernel
+	Vec3 light; // direction towards the light, zero for face characters
+	const char* mesh_path; // OBJ or PLY file, for bin/model
+	int mesh_cache;		   // reuse or write <mesh_path>.spincache
+	int objects;		   // objects on the wall, for bin/wall; 0 for default
+	const char* record_path; // write the frames shown to this file
+	const char* replay_path; // recording to play, for bin/play
+	int loop;				 // replay from the start when it ends
+	int replay_from;		 // first frame to play
+	int cycle_cache; // serve repeated frames of the cycle from memory
+	int cycle_steps; // frames per cycle, 0 for one per tick
+	int cache_mb;	 // memory budget of the cycle cache
+	const char* stats_path; // log the instrumentation totals here
+	int stats_json;			// as JSON lines instead of CSV
+	int stats_overlay;		// show them on the top row of the frame
+} Options;
+
+/* Function Prototypes */
+int options_parse(Options* o, int argc, char** argv);
+int options_output_fd(const Options* o);
+
+#endif
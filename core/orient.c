@@ -0,0 +1,161 @@
+// orient.c
+
+#include "core/orient.h"
+
+#include <math.h>
+
+#include "core/alloc.h"
+
+#define PI 3.14159265358979323846
+
+/* Angle about one axis at a tick, wrapped to avoid precision loss */
+static double orient_angle(const Orienter* o, double rate,
+						   unsigned long long tick) {
+	return fmod(tick * o->period * rate, 2 * PI);
+}
+
+static HalfTurn half_turn(double theta) {
+	HalfTurn h = {cos(theta / 2), sin(theta / 2)};
+	return h;
+}
+
+/* Rotates h by step, then pulls it back to unit length without a sqrt */
+static HalfTurn half_turn_step(HalfTurn h, HalfTurn step) {
+	HalfTurn r = {h.c * step.c - h.s * step.s, h.s * step.c + h.c * step.s};
+	double k = (3 - (r.c * r.c + r.s * r.s)) / 2;
+	r.c *= k;
+	r.s *= k;
+	return r;
+}
+
+/* quat_from_euler from the half-turns about x, y and z */
+static Quat orient_compose(const HalfTurn h[3]) {
+	Quat qx = {h[0].c, h[0].s, 0, 0};
+	Quat qy = {h[1].c, 0, h[1].s, 0};
+	Quat qz = {h[2].c, 0, 0, h[2].s};
+	return quat_normalize(quat_mul(qx, quat_mul(qy, qz)));
+}
+
+/*
+ * Entry of the quantised table nearest to theta in (-2pi, 2pi): negative
+ * rates give negative angles, whose index wraps around from the end
+ */
+static HalfTurn table_lookup(const Orienter* o, double theta) {
+	long i = (long) floor(theta * (ORIENT_TABLE_SIZE / (2 * PI)) + 0.5);
+	return o->table[((i % ORIENT_TABLE_SIZE) + ORIENT_TABLE_SIZE) %
+					ORIENT_TABLE_SIZE];
+}
+
+/* Sets up mode for the given rates and tick period, 0 on failure */
+int orient_init(Orienter* o, OrientMode mode, Vec3 rates, double period) {
+	o->mode = mode;
+	o->rates = rates;
+	o->period = period;
+	o->valid = 0;
+	o->tick = o->synced = 0;
+	o->table = NULL;
+
+	double r[3] = {rates.x, rates.y, rates.z};
+	for (int a = 0; a < 3; a++) o->step[a] = half_turn(r[a] * period);
+
+	if (mode == ORIENT_TABLE)
+	{
+		o->table = mem_alloc(sizeof(HalfTurn) * ORIENT_TABLE_SIZE);
+		if (!o->table) return 0;
+		for (int i = 0; i < ORIENT_TABLE_SIZE; i++)
+			o->table[i] = half_turn(2 * PI * i / ORIENT_TABLE_SIZE);
+	}
+	return 1;
+}
+
+void orient_free(Orienter* o) {
+	mem_free(o->table);
+	o->table = NULL;
+}
+
+/* Reference orientation of a tick: six sin/cos calls */
+Quat orient_exact(const Orienter* o, unsigned long long tick) {
+	return quat_from_euler(orient_angle(o, o->rates.x, tick),
+						   orient_angle(o, o->rates.y, tick),
+						   orient_angle(o, o->rates.z, tick));
+}
+
+/*
+ * Orientation of a tick in the selected mode. ORIENT_STEP falls back to
+ * the exact angles when the tick goes backwards, jumps further than
+ * ORIENT_MAX_STEPS or every ORIENT_RESYNC ticks, so rounding never builds
+ * up; in between it costs a few multiplications per frame.
+ */
+Quat orient_at(Orienter* o, unsigned long long tick) {
+	double r[3] = {o->rates.x, o->rates.y, o->rates.z};
+	HalfTurn h[3];
+
+	switch (o->mode)
+	{
+	case ORIENT_STEP:
+		if (!o->valid || tick < o->tick || tick - o->tick > ORIENT_MAX_STEPS ||
+			tick - o->synced >= ORIENT_RESYNC)
+		{
+			for (int a = 0; a < 3; a++)
+				o->cur[a] = half_turn(orient_angle(o, r[a], tick));
+			o->tick = o->synced = tick;
+			o->valid = 1;
+		}
+		for (; o->tick < tick; o->tick++)
+			for (int a = 0; a < 3; a++)
+				o->cur[a] = half_turn_step(o->cur[a], o->step[a]);
+		return orient_compose(o->cur);
+
+	case ORIENT_TABLE:
+		for (int a = 0; a < 3; a++)
+			h[a] = table_lookup(o, orient_angle(o, r[a], tick));
+		return orient_compose(h);
+
+	default: return orient_exact(o, tick);
+	}
+}
+
+/* Slowest non-zero rate; the others must be whole multiples of it */
+static double orient_base_rate(const Orienter* o) {
+	double r[3] = {fabs(o->rates.x), fabs(o->rates.y), fabs(o->rates.z)};
+	double base = 0;
+	for (int a = 0; a < 3; a++)
+		if (r[a] > 0 && (base == 0 || r[a] < base)) base = r[a];
+
+	for (int a = 0; a < 3 && base > 0; a++)
+	{
+		double k = r[a] / base;
+		if (fabs(k - round(k)) > 1e-9) return 0;
+	}
+	return base;
+}
+
+/*
+ * Ticks in one cycle of the animation, after which every angle has made
+ * whole turns, rounded to the nearest tick. 0 if the rotation never
+ * repeats (no rotation, or rates that are not multiples of each other).
+ */
+int orient_cycle_ticks(const Orienter* o) {
+	double base = orient_base_rate(o);
+	if (base == 0) return 0;
+	double ticks = 2 * PI / (base * o->period);
+	return ticks < 1 ? 1 : ticks > 1 << 24 ? 0 : (int) (ticks + 0.5);
+}
+
+/*
+ * Stretches the tick period so that a cycle takes exactly ticks ticks:
+ * tick t and t + ticks then have the same orientation. The rotation must
+ * repeat. Returns 0 on failure.
+ */
+int orient_set_cycle(Orienter* o, int ticks) {
+	double base = orient_base_rate(o);
+	orient_free(o);
+	return orient_init(o, o->mode, o->rates, 2 * PI / (base * ticks));
+}
+
+/* Angle of the rotation taking unit quaternion a to b, in radians */
+double quat_angle_between(Quat a, Quat b) {
+	Quat inv = {a.w, -a.x, -a.y, -a.z};
+	Quat d = quat_mul(inv, b);
+	return 2 * atan2(sqrt(d.x * d.x + d.y * d.y + d.z * d.z), fabs(d.w));
+}
@@ -0,0 +1,53 @@
+// orient.h
+
+#ifndef ORIENT_H
+#define ORIENT_H
+
+#include "core/linalg.h"
+
+/* How the orientation of a tick is computed */
+typedef enum {
+	ORIENT_EXACT, // sin/cos of the tick's angles, once per frame
+	ORIENT_STEP,  // advance by a precomputed per-tick rotation, no trig
+	ORIENT_TABLE, // nearest entry of a quantised angle table, no trig
+} OrientMode;
+
+#define ORIENT_TABLE_SIZE 4096 // angles per turn in ORIENT_TABLE
+#define ORIENT_RESYNC 4096	   // ticks between exact resyncs in ORIENT_STEP
+#define ORIENT_MAX_STEPS 16	   // longer jumps resync instead of stepping
+
+/* Structures */
+
+/* Cosine and sine of half an angle: one axis factor of a quaternion */
+typedef struct {
+	double c, s;
+} HalfTurn;
+
+/*
+ * Orientation of the spinning shape as a function of the scheduler tick:
+ * Euler angles rates * tick * period about x, y and z, composed like
+ * quat_from_euler. Each axis factor is a rotation about a fixed axis, so
+ * advancing it one tick is a multiplication by a constant half-turn.
+ */
+typedef struct {
+	OrientMode mode;
+	Vec3 rates;	   // radians per second about x, y and z
+	double period; // seconds per tick
+	HalfTurn step[3];
+	HalfTurn cur[3];		   // ORIENT_STEP: factors at tick
+	unsigned long long tick;   // tick cur is at
+	unsigned long long synced; // tick of the last exact resync
+	int valid;				   // cur holds a tick
+	HalfTurn* table;		   // ORIENT_TABLE_SIZE entries
+} Orienter;
+
+/* Function Prototypes */
+int orient_init(Orienter* o, OrientMode mode, Vec3 rates, double period);
+void orient_free(Orienter* o);
+Quat orient_exact(const Orienter* o, unsigned long long tick);
+Quat orient_at(Orienter* o, unsigned long long tick);
+int orient_cycle_ticks(const Orienter* o);
+int orient_set_cycle(Orienter* o, int ticks);
+double quat_angle_between(Quat a, Quat b);
+
+#endif
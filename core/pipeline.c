@@ -0,0 +1,180 @@
+// pipeline.c
+
+#include "core/pipeline.h"
+
+#include <sched.h>
+#include <string.h>
+
+#include "core/alloc.h"
+
+/* Yields before a wait parks on the condition variable */
+#define PIPELINE_SPINS 64
+
+static void* pipeline_presenter(void* arg);
+
+/*
+ * Waits until the other side moves *watched off seen. A few yields catch
+ * a busy ring; then the thread parks until woken. parked is raised before
+ * watched is read again, and the other side stores watched before it
+ * reads parked, both sequentially consistent: either this thread sees the
+ * move or the other sees it parked and wakes it.
+ */
+static void pipeline_wait(Pipeline* p, int* parked, const unsigned* watched,
+						  unsigned seen) {
+	for (int i = 0; i < PIPELINE_SPINS; i++)
+	{
+		if (__atomic_load_n(watched, __ATOMIC_ACQUIRE) != seen) return;
+		sched_yield();
+	}
+
+	pthread_mutex_lock(&p->lock);
+	__atomic_store_n(parked, 1, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(watched, __ATOMIC_SEQ_CST) == seen && !p->quit)
+		pthread_cond_wait(&p->cond, &p->lock);
+	__atomic_store_n(parked, 0, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&p->lock);
+}
+
+/* Wakes the other side if it is parked, after a store it waits for */
+static void pipeline_wake(Pipeline* p, const int* parked) {
+	if (!__atomic_load_n(parked, __ATOMIC_SEQ_CST)) return;
+	pthread_mutex_lock(&p->lock);
+	pthread_cond_broadcast(&p->cond);
+	pthread_mutex_unlock(&p->lock);
+}
+
+static int slots_alloc(Pipeline* p, int cells) {
+	p->cells = cells;
+	for (int i = 0; i < PIPELINE_SLOTS; i++)
+	{
+		p->slots[i].cells = mem_alloc(cells);
+		if (!p->slots[i].cells) return 0;
+	}
+	return 1;
+}
+
+static void slots_release(Pipeline* p) {
+	for (int i = 0; i < PIPELINE_SLOTS; i++)
+	{
+		mem_free(p->slots[i].cells);
+		p->slots[i].cells = NULL;
+	}
+}
+
+/*
+ * Allocates the ring for frames of cells cells and starts the presenting
+ * thread; without one, frames are sent as they are published. Returns 0
+ * on failure.
+ */
+int pipeline_init(Pipeline* p, Presenter* presenter, Bench* bench, int cells) {
+	memset(p, 0, sizeof(*p));
+	p->presenter = presenter;
+	p->bench = bench;
+	if (!slots_alloc(p, cells))
+	{
+		slots_release(p);
+		return 0;
+	}
+
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->cond, NULL);
+	p->running = pthread_create(&p->thread, NULL, pipeline_presenter, p) == 0;
+	if (!p->running)
+	{
+		pthread_mutex_destroy(&p->lock);
+		pthread_cond_destroy(&p->cond);
+	}
+	return 1;
+}
+
+/* Sends every published frame, stops the thread and frees the ring */
+void pipeline_free(Pipeline* p) {
+	if (p->running)
+	{
+		pipeline_flush(p);
+		pthread_mutex_lock(&p->lock);
+		p->quit = 1;
+		pthread_cond_broadcast(&p->cond);
+		pthread_mutex_unlock(&p->lock);
+		pthread_join(p->thread, NULL);
+
+		pthread_mutex_destroy(&p->lock);
+		pthread_cond_destroy(&p->cond);
+		p->running = 0;
+	}
+	slots_release(p);
+}
+
+/* Reallocates the ring for a new frame size once it is empty */
+int pipeline_resize(Pipeline* p, int cells) {
+	pipeline_flush(p);
+	slots_release(p);
+	return slots_alloc(p, cells);
+}
+
+/* Waits for a free slot and returns its cells to draw the next frame in */
+char* pipeline_acquire(Pipeline* p) {
+	while (p->head - __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE) ==
+		   PIPELINE_SLOTS)
+		pipeline_wait(p, &p->producer_parked, &p->tail,
+					  p->head - PIPELINE_SLOTS);
+	return p->slots[p->head % PIPELINE_SLOTS].cells;
+}
+
+/* Sends one slot's frame and reports it to the bench */
+static void pipeline_send(Pipeline* p, PipelineSlot* slot) {
+	present_frame(p->presenter, slot->cells);
+	bench_sent(p->bench, slot->frame, slot->start);
+}
+
+/*
+ * Hands the acquired slot over to be sent. The caller may keep reading
+ * its cells, but must not write them again until it is acquired anew.
+ */
+void pipeline_publish(Pipeline* p, int frame, double start) {
+	PipelineSlot* slot = &p->slots[p->head % PIPELINE_SLOTS];
+	slot->frame = frame;
+	slot->start = start;
+
+	if (!p->running)
+	{
+		pipeline_send(p, slot);
+		p->head++;
+		p->tail++;
+		return;
+	}
+	__atomic_store_n(&p->head, p->head + 1, __ATOMIC_SEQ_CST);
+	pipeline_wake(p, &p->consumer_parked);
+}
+
+/* Waits until every published frame has been sent */
+void pipeline_flush(Pipeline* p) {
+	unsigned tail;
+	while ((tail = __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE)) != p->head)
+		pipeline_wait(p, &p->producer_parked, &p->tail, tail);
+	presenter_flush(p->presenter);
+}
+
+/* Presenting thread: sends each published slot in turn */
+static void* pipeline_presenter(void* arg) {
+	Pipeline* p = arg;
+
+	while (1)
+	{
+		unsigned head = __atomic_load_n(&p->head, __ATOMIC_ACQUIRE);
+		if (p->tail == head)
+		{
+			pthread_mutex_lock(&p->lock);
+			int quit = p->quit;
+			pthread_mutex_unlock(&p->lock);
+			if (quit) break;
+			pipeline_wait(p, &p->consumer_parked, &p->head, head);
+			continue;
+		}
+
+		pipeline_send(p, &p->slots[p->tail % PIPELINE_SLOTS]);
+		__atomic_store_n(&p->tail, p->tail + 1, __ATOMIC_SEQ_CST);
+		pipeline_wake(p, &p->producer_parked);
+	}
+	return NULL;
+}
@@ -0,0 +1,55 @@
+// pipeline.h
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+
+#include "core/bench.h"
+#include "core/present.h"
+
+/* Frames in flight between the render and the presenting thread */
+#define PIPELINE_SLOTS 4
+
+/* Structures */
+
+/* One frame buffer of the ring, and what the bench needs to know of it */
+typedef struct {
+	char* cells;
+	int frame;	  // bench index, -1 when not timed
+	double start; // when the frame was started, for its latency
+} PipelineSlot;
+
+/*
+ * Pipelined presenting: the render thread draws frame N + 1 into one slot
+ * of a ring while a presenting thread assembles and sends frame N from
+ * another. The ring has a single producer and a single consumer, so the
+ * two only share the head and tail counters: each is written by one side
+ * and read by the other, with no lock. A side that finds the ring full or
+ * empty yields briefly, then parks on the condition variable until the
+ * other side moves its counter.
+ */
+typedef struct {
+	Presenter* presenter;
+	Bench* bench;
+	PipelineSlot slots[PIPELINE_SLOTS];
+	int cells; // size of every slot
+	unsigned head; // slots published, written by the render thread only
+	unsigned tail; // slots sent, written by the presenting thread only
+	int producer_parked, consumer_parked; // waiting on cond
+	int quit;							  // under lock
+	int running;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} Pipeline;
+
+/* Function Prototypes */
+int pipeline_init(Pipeline* p, Presenter* presenter, Bench* bench, int cells);
+void pipeline_free(Pipeline* p);
+int pipeline_resize(Pipeline* p, int cells);
+char* pipeline_acquire(Pipeline* p);
+void pipeline_publish(Pipeline* p, int frame, double start);
+void pipeline_flush(Pipeline* p);
+
+#endif
@@ -0,0 +1,37 @@
+// points.c
+
+#include "core/points.h"
+
+#include "core/alloc.h"
+
+/* Allocates the three coordinate arrays, returns 0 on failure */
+int points_init(PointsSoA* pts, int count) {
+	/* Round each array up to a whole number of AVX vectors */
+	size_t lanes = POINTS_ALIGN / sizeof(real);
+	size_t padded = (count + lanes - 1) / lanes * lanes;
+	size_t bytes = padded * sizeof(real);
+
+	pts->x = mem_alloc_aligned(bytes, POINTS_ALIGN);
+	pts->y = mem_alloc_aligned(bytes, POINTS_ALIGN);
+	pts->z = mem_alloc_aligned(bytes, POINTS_ALIGN);
+	pts->count = count;
+
+	if (!pts->x || !pts->y || !pts->z)
+	{
+		points_free(pts);
+		return 0;
+	}
+
+	for (size_t i = 0; i < padded; i++) pts->x[i] = pts->y[i] = pts->z[i] = 0;
+	return 1;
+}
+
+/* Frees the coordinate arrays */
+void points_free(PointsSoA* pts) {
+	mem_free_aligned(pts->x);
+	mem_free_aligned(pts->y);
+	mem_free_aligned(pts->z);
+	pts->x = pts->y = pts->z = NULL;
+	pts->count = 0;
+}
+
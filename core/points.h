@@ -0,0 +1,70 @@
+// points.h
+
+#ifndef POINTS_H
+#define POINTS_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include "core/linalg.h"
+
+/*
+ * Precision of the point buffer, the projection and the depth buffer
+ * (make PRECISION=double|float|fixed). Fixed is 16.16 in an int32_t, so
+ * point coordinates and depths must stay within +-32768: the shapes are
+ * tens of units across, at depths between the near and far planes. The
+ * projection matrix can exceed that and is kept in 64 bits, see kernels.c.
+ */
+#if defined(SPIN_FIXED16)
+typedef int32_t real;
+#define REAL_FRAC_BITS 16
+#define REAL_FAR INT32_MAX // depth beyond anything drawn
+
+static inline real real_from_double(double v) {
+	return (real) lrint(v * (1 << REAL_FRAC_BITS));
+}
+
+static inline double real_to_double(real v) {
+	return v / (double) (1 << REAL_FRAC_BITS);
+}
+#else
+#ifdef SPIN_FLOAT32
+typedef float real;
+#else
+typedef double real;
+#endif
+#define REAL_FAR INFINITY
+
+static inline real real_from_double(double v) { return (real) v; }
+static inline double real_to_double(real v) { return v; }
+#endif
+
+/* Alignment of each coordinate array, enough for AVX loads */
+#define POINTS_ALIGN 32
+
+/* Structures */
+
+/* Structure-of-arrays point buffer: x, y and z live in separate arrays */
+typedef struct {
+	real* x;
+	real* y;
+	real* z;
+	int count;
+} PointsSoA;
+
+/* Function Prototypes */
+int points_init(PointsSoA* pts, int count);
+void points_free(PointsSoA* pts);
+
+static inline void points_set(PointsSoA* pts, int i, Vec3 p) {
+	pts->x[i] = real_from_double(p.x);
+	pts->y[i] = real_from_double(p.y);
+	pts->z[i] = real_from_double(p.z);
+}
+
+static inline Vec3 points_get(const PointsSoA* pts, int i) {
+	return vec3(real_to_double(pts->x[i]), real_to_double(pts->y[i]),
+				real_to_double(pts->z[i]));
+}
+
+#endif
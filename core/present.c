@@ -0,0 +1,315 @@
+// present.c
+
+#include "core/present.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "core/alloc.h"
+#include "core/stats.h"
+
+/*
+ * Unchanged cells between two changed runs are rewritten instead of
+ * skipped when the gap is shorter than a cursor move sequence.
+ */
+#define MIN_GAP 8
+
+/* Full mode layout: clear, home, then each row followed by a newline */
+static const char full_clear[] = "\033[2J";
+static const char full_home[] = "\033[H";
+#define FULL_ROWS (sizeof(full_clear) - 1 + sizeof(full_home) - 1)
+
+static void* presenter_writer(void* arg);
+
+/* Allocates the front and output buffers for width x height cells */
+static int presenter_alloc(Presenter* p, int width, int height) {
+	int buffers = p->double_buffer ? 2 : 1;
+	p->width = width;
+	p->height = height;
+	p->valid = 0;
+	p->cur = 0;
+
+	if (p->mode == PRESENT_FULL)
+		p->out_cap = FULL_ROWS + (size_t) (width + 1) * height;
+	else
+	{
+		/* Worst case: a cursor move per MIN_GAP + 1 cells, plus the clear */
+		size_t moves = (size_t) height * (width / (MIN_GAP + 1) + 1);
+		p->out_cap = (size_t) width * height + moves * 12 + 32;
+	}
+
+	p->front = mem_alloc((size_t) width * height);
+	for (int b = 0; b < buffers; b++) p->out[b] = mem_alloc(p->out_cap);
+	if (!p->front || !p->out[0] || (buffers == 2 && !p->out[1])) return 0;
+
+	/* The escape sequences and row terminators never move */
+	if (p->mode == PRESENT_FULL)
+		for (int b = 0; b < buffers; b++)
+		{
+			memcpy(p->out[b], full_clear, sizeof(full_clear) - 1);
+			memcpy(p->out[b] + sizeof(full_clear) - 1, full_home,
+				   sizeof(full_home) - 1);
+			for (int y = 0; y < height; y++)
+				p->out[b][FULL_ROWS + (size_t) (width + 1) * y + width] = '\n';
+		}
+	return 1;
+}
+
+static void presenter_release(Presenter* p) {
+	mem_free(p->front);
+	mem_free(p->out[0]);
+	mem_free(p->out[1]);
+	p->front = p->out[0] = p->out[1] = NULL;
+}
+
+/* Allocates the buffers and starts the writer, returns 0 on failure */
+int presenter_init(Presenter* p, int fd, int width, int height,
+				   PresentMode mode, int async) {
+	memset(p, 0, sizeof(*p));
+	p->fd = fd;
+	p->mode = mode;
+	p->double_buffer = async;
+
+	if (!presenter_alloc(p, width, height))
+	{
+		presenter_release(p);
+		return 0;
+	}
+
+	if (async)
+	{
+		pthread_mutex_init(&p->lock, NULL);
+		pthread_cond_init(&p->cond, NULL);
+		p->async = pthread_create(&p->writer, NULL, presenter_writer, p) == 0;
+		if (!p->async)
+		{
+			pthread_mutex_destroy(&p->lock);
+			pthread_cond_destroy(&p->cond);
+		}
+	}
+	return 1;
+}
+
+/* Waits for the last frame to be written and frees the buffers */
+void presenter_free(Presenter* p) {
+	if (p->async)
+	{
+		pthread_mutex_lock(&p->lock);
+		p->quit = 1;
+		pthread_cond_broadcast(&p->cond);
+		pthread_mutex_unlock(&p->lock);
+		pthread_join(p->writer, NULL);
+
+		pthread_mutex_destroy(&p->lock);
+		pthread_cond_destroy(&p->cond);
+		p->async = 0;
+	}
+	presenter_release(p);
+}
+
+/*
+ * Reallocates the buffers for a new frame size once the writer is idle.
+ * The next frame redraws the whole screen. Returns 0 on failure.
+ */
+int presenter_resize(Presenter* p, int width, int height) {
+	presenter_flush(p);
+	presenter_release(p);
+	return presenter_alloc(p, width, height);
+}
+
+/*
+ * Forces the next frame to clear the screen and redraw everything. Call
+ * it from the thread that presents, or once the frames are flushed.
+ */
+void presenter_invalidate(Presenter* p) { p->valid = 0; }
+
+/* Appends "ESC[row;colH" (1-based) and returns the new length */
+static size_t put_move(char* out, size_t len, int row, int col) {
+	char digits[12];
+	int n;
+
+	out[len++] = '\033';
+	out[len++] = '[';
+	n = 0;
+	do digits[n++] = '0' + row % 10;
+	while (row /= 10);
+	while (n) out[len++] = digits[--n];
+	out[len++] = ';';
+	do digits[n++] = '0' + col % 10;
+	while (col /= 10);
+	while (n) out[len++] = digits[--n];
+	out[len++] = 'H';
+	return len;
+}
+
+/*
+ * Writes all of buf, retrying on partial writes, and counts the syscalls.
+ * A negative fd is a memory sink: the frame is composed but never sent.
+ */
+static void write_all(Presenter* p, const char* buf, size_t len) {
+	size_t done = p->fd < 0 ? len : 0;
+	unsigned long calls = 0;
+	while (done < len)
+	{
+		ssize_t n = write(p->fd, buf + done, len - done);
+		calls++;
+		if (n < 0)
+		{
+			if (errno == EINTR) continue;
+			break;
+		}
+		done += n;
+	}
+
+	STATS_ADD(STATS_BYTES, done);
+	if (p->async) pthread_mutex_lock(&p->lock);
+	p->stats.frames++;
+	p->stats.syscalls += calls;
+	p->stats.bytes += done;
+	if (p->async) pthread_mutex_unlock(&p->lock);
+}
+
+/* Writer thread: sends each handed-over buffer in turn */
+static void* presenter_writer(void* arg) {
+	Presenter* p = arg;
+
+	pthread_mutex_lock(&p->lock);
+	while (1)
+	{
+		while (!p->pending && !p->quit) pthread_cond_wait(&p->cond, &p->lock);
+		if (!p->pending) break;
+
+		const char* buf = p->pending;
+		size_t len = p->pending_len;
+		p->pending = NULL;
+		p->busy = 1;
+		pthread_mutex_unlock(&p->lock);
+
+		write_all(p, buf, len);
+
+		pthread_mutex_lock(&p->lock);
+		p->busy = 0;
+		pthread_cond_broadcast(&p->cond);
+	}
+	pthread_mutex_unlock(&p->lock);
+	return NULL;
+}
+
+/* Assembles every cell into the fixed layout, returns the start offset */
+static size_t compose_full(Presenter* p, const char* cells, char* out) {
+	for (int y = 0; y < p->height; y++)
+		memcpy(out + FULL_ROWS + (size_t) (p->width + 1) * y,
+			   cells + (size_t) y * p->width, p->width);
+
+	/* Skip the clear once the screen is known to be blank */
+	size_t start = p->valid ? sizeof(full_clear) - 1 : 0;
+	p->valid = 1;
+	return start;
+}
+
+/* Assembles the cells that differ from the front buffer, returns length */
+static size_t compose_diff(Presenter* p, const char* cells, char* out) {
+	size_t len = 0;
+
+	if (!p->valid)
+	{
+		/* A cleared screen is all blanks */
+		memcpy(out, full_clear, sizeof(full_clear) - 1);
+		len = sizeof(full_clear) - 1;
+		memset(p->front, ' ', (size_t) p->width * p->height);
+		p->valid = 1;
+	}
+
+	for (int y = 0; y < p->height; y++)
+	{
+		const char* row = cells + (size_t) y * p->width;
+		char* front = p->front + (size_t) y * p->width;
+		int x = 0;
+
+		while (x < p->width)
+		{
+			/* Find the next changed run */
+			while (x < p->width && row[x] == front[x]) x++;
+			if (x == p->width) break;
+
+			int start = x, end = x;
+			while (x < p->width)
+			{
+				if (row[x] != front[x])
+					end = ++x;
+				else if (x - end < MIN_GAP)
+					x++;
+				else
+					break;
+			}
+
+			len = put_move(out, len, y + 1, start + 1);
+			memcpy(out + len, row + start, end - start);
+			memcpy(front + start, row + start, end - start);
+			len += end - start;
+			x = end;
+		}
+	}
+
+	/* Park the cursor below the frame */
+	if (len) len = put_move(out, len, p->height + 1, 1);
+	return len;
+}
+
+/* Sends a frame of width x height cells */
+void present_frame(Presenter* p, const char* cells) {
+	STATS_BEGIN(t);
+	char* out = p->out[p->cur];
+	const char* buf = out;
+	size_t len;
+
+	if (p->mode == PRESENT_FULL)
+	{
+		size_t start = compose_full(p, cells, out);
+		buf = out + start;
+		len = p->out_cap - start;
+	}
+	else
+		len = compose_diff(p, cells, out);
+
+	if (len == 0)
+	{
+		STATS_END(t, STATS_OUTPUT);
+		return;
+	}
+
+	if (!p->async)
+	{
+		write_all(p, buf, len);
+		STATS_END(t, STATS_OUTPUT);
+		return;
+	}
+
+	/* Hand the buffer over once the writer has finished the previous one */
+	pthread_mutex_lock(&p->lock);
+	while (p->pending || p->busy) pthread_cond_wait(&p->cond, &p->lock);
+	p->pending = buf;
+	p->pending_len = len;
+	pthread_cond_broadcast(&p->cond);
+	pthread_mutex_unlock(&p->lock);
+
+	p->cur ^= 1;
+	STATS_END(t, STATS_OUTPUT);
+}
+
+/* Waits until every handed-over frame has been written */
+void presenter_flush(Presenter* p) {
+	if (!p->async) return;
+	pthread_mutex_lock(&p->lock);
+	while (p->pending || p->busy) pthread_cond_wait(&p->cond, &p->lock);
+	pthread_mutex_unlock(&p->lock);
+}
+
+/* Returns a snapshot of the output counters */
+PresentStats presenter_stats(Presenter* p) {
+	if (p->async) pthread_mutex_lock(&p->lock);
+	PresentStats s = p->stats;
+	if (p->async) pthread_mutex_unlock(&p->lock);
+	return s;
+}
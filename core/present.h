@@ -0,0 +1,63 @@
+// present.h
+
+#ifndef PRESENT_H
+#define PRESENT_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+/* How frames are sent to the terminal */
+typedef enum {
+	PRESENT_DIFF, // only the cells that changed, with cursor moves
+	PRESENT_FULL, // every cell, into a preassembled home + rows layout
+} PresentMode;
+
+/* Structures */
+
+/* Output counters, for benchmarks */
+typedef struct {
+	unsigned long frames;
+	unsigned long syscalls;
+	unsigned long bytes;
+} PresentStats;
+
+/*
+ * Terminal presenter. Each frame is assembled into one contiguous output
+ * buffer and sent with a single write(). In diff mode the front buffer
+ * holds what the terminal currently shows and only changed runs of cells
+ * are sent. With async set, a writer thread sends frame N from one output
+ * buffer while the caller composes frame N + 1 into the other.
+ */
+typedef struct {
+	int fd; // negative: compose only, for benchmarks
+	int width, height;
+	PresentMode mode;
+	char* front;
+	char* out[2];
+	size_t out_cap;
+	int cur;		   // output buffer being composed
+	int double_buffer; // out[1] is allocated
+	int valid; // 0 until the screen has been cleared once
+	PresentStats stats;
+
+	/* Asynchronous writer */
+	int async;
+	pthread_t writer;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	const char* pending; // bytes handed to the writer, NULL if none
+	size_t pending_len;
+	int busy, quit;
+} Presenter;
+
+/* Function Prototypes */
+int presenter_init(Presenter* p, int fd, int width, int height,
+				   PresentMode mode, int async);
+void presenter_free(Presenter* p);
+int presenter_resize(Presenter* p, int width, int height);
+void presenter_invalidate(Presenter* p);
+void presenter_flush(Presenter* p);
+PresentStats presenter_stats(Presenter* p);
+void present_frame(Presenter* p, const char* cells);
+
+#endif
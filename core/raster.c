@@ -0,0 +1,121 @@
+// raster.c
+
+#include "core/raster.h"
+
+#include <math.h>
+
+#include "core/stats.h"
+
+/*
+ * Projects every vertex to screen space: x and y in cell units with the
+ * origin at the top-left corner, z the same depth value the point path
+ * tests (cz / cw). Vertices behind the camera get an infinite depth and
+ * the triangles using them are skipped.
+ */
+void raster_project(Mesh* m, const Mat4* mvp, int width, int height) {
+	int half_w = width / 2;
+	int half_h = height / 2;
+	STATS_BEGIN(t);
+	STATS_ONLY(int behind = 0;)
+
+	for (int i = 0; i < m->num_verts; i++)
+	{
+		Vec4 c = mat4_mul_point(mvp, m->verts[i]);
+		if (c.w <= 0)
+		{
+			m->screen[i] = vec3(0, 0, INFINITY);
+			STATS_ONLY(behind++;)
+			continue;
+		}
+		m->screen[i] =
+			vec3(c.x / c.w + half_w, c.y / c.w + half_h, c.z / c.w);
+	}
+	STATS_END(t, STATS_PROJECT);
+	STATS_ADD(STATS_POINTS, m->num_verts);
+	STATS_ADD(STATS_OFFSCREEN, behind);
+}
+
+/* x where the edge a-b crosses the horizontal line y */
+static inline double edge_x(Vec3 a, Vec3 b, double y) {
+	return a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y);
+}
+
+/*
+ * Scanline fill of one triangle over rows [row_begin, row_end). A cell
+ * is covered when its center is; the half-open spans keep shared edges
+ * from being drawn twice or not at all. z / w is affine in screen space,
+ * so interpolating it along the plane is perspective-correct.
+ */
+static void raster_triangle(Frame* f, Vec3 a, Vec3 b, Vec3 c, char ch,
+							int cull, int row_begin, int row_end) {
+	/* Outward-wound triangles facing the camera have a negative area */
+	double area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+	if (area == 0 || (cull && area > 0)) return;
+
+	/* Depth plane: z = a.z + dzdx * (x - a.x) + dzdy * (y - a.y) */
+	double dzdx =
+		((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / area;
+	double dzdy =
+		((b.x - a.x) * (c.z - a.z) - (c.x - a.x) * (b.z - a.z)) / area;
+
+	/* Sort by y: a on top, c at the bottom */
+	Vec3 t;
+	if (b.y < a.y) t = a, a = b, b = t;
+	if (c.y < a.y) t = a, a = c, c = t;
+	if (c.y < b.y) t = b, b = c, c = t;
+
+	int y0 = (int) ceil(a.y - 0.5);
+	int y1 = (int) ceil(c.y - 0.5);
+	if (y0 < row_begin) y0 = row_begin;
+	if (y1 > row_end) y1 = row_end;
+	STATS_ONLY(int rejected = 0;)
+
+	for (int y = y0; y < y1; y++)
+	{
+		double yc = y + 0.5;
+		double xl = edge_x(a, c, yc);
+		double xr = yc < b.y ? edge_x(a, b, yc) : edge_x(b, c, yc);
+		if (xl > xr) t.x = xl, xl = xr, xr = t.x;
+
+		int x0 = (int) ceil(xl - 0.5);
+		int x1 = (int) ceil(xr - 0.5);
+		if (x0 < 0) x0 = 0;
+		if (x1 > f->width) x1 = f->width;
+		if (x0 >= x1) continue;
+
+		double z = a.z + dzdx * (x0 + 0.5 - a.x) + dzdy * (yc - a.y);
+		real* zrow = f->z + (long) y * f->width;
+		char* crow = f->cells + (long) y * f->width;
+		for (int x = x0; x < x1; x++, z += dzdx)
+		{
+			/* Interpolated in double, stored in the buffer's precision */
+			real zq = real_from_double(z);
+			if (zq < zrow[x])
+			{
+				zrow[x] = zq;
+				crow[x] = ch;
+			}
+			STATS_ONLY(else rejected++;)
+		}
+	}
+	STATS_ADD(STATS_REJECTED, rejected);
+}
+
+/* Rasterizes every triangle of the projected mesh into rows [begin, end) */
+void raster_mesh(Frame* f, const Mesh* m, int row_begin, int row_end) {
+	if (row_begin < 0) row_begin = 0;
+	if (row_end > f->height) row_end = f->height;
+	STATS_BEGIN(t);
+
+	for (int i = 0; i < m->num_tris; i++)
+	{
+		const Triangle* tri = &m->tris[i];
+		Vec3 a = m->screen[tri->v[0]];
+		Vec3 b = m->screen[tri->v[1]];
+		Vec3 c = m->screen[tri->v[2]];
+		if (isinf(a.z) || isinf(b.z) || isinf(c.z)) continue;
+
+		raster_triangle(f, a, b, c, tri->ch, m->cull, row_begin, row_end);
+	}
+	STATS_END(t, STATS_DEPTH);
+}
@@ -0,0 +1,13 @@
+// raster.h
+
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "core/mesh.h"
+#include "core/render.h"
+
+/* Function Prototypes */
+void raster_project(Mesh* m, const Mat4* mvp, int width, int height);
+void raster_mesh(Frame* f, const Mesh* m, int row_begin, int row_end);
+
+#endif
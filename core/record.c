@@ -0,0 +1,365 @@
+// record.c
+
+#include "core/record.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "core/alloc.h"
+
+/*
+ * Recording format, little-endian throughout:
+ *
+ *   header   "SPINREC1", u32 width, u32 height, u64 period_ns,
+ *            u32 num_frames, u32 key_interval, u64 index_offset
+ *   frames   u8 kind, varint tick, varint payload size, payload
+ *   index    u64 file offset of each frame
+ *
+ * A keyframe ('K') is the run-length encoded screen: (varint run, char)
+ * pairs. A delta ('D') is XORed onto the previous screen: groups of
+ * (varint unchanged cells, varint n, n XOR bytes), ending at the last
+ * changed cell. Every key_interval-th frame is a keyframe, so a seek
+ * decodes at most that many frames. The header is rewritten with
+ * the frame count and the index position when the recording is closed.
+ */
+
+#define RECORD_MAGIC "SPINREC1"
+#define HEADER_SIZE 40
+
+#define FRAME_KEY 'K'
+#define FRAME_DELTA 'D'
+
+/* Unchanged cells worth splitting a delta group for */
+#define DELTA_MIN_GAP 3
+
+static void put_u32(unsigned char* p, uint32_t v) {
+	for (int i = 0; i < 4; i++) p[i] = (unsigned char) (v >> (8 * i));
+}
+
+static void put_u64(unsigned char* p, uint64_t v) {
+	for (int i = 0; i < 8; i++) p[i] = (unsigned char) (v >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+	uint32_t v = 0;
+	for (int i = 0; i < 4; i++) v |= (uint32_t) p[i] << (8 * i);
+	return v;
+}
+
+static uint64_t get_u64(const unsigned char* p) {
+	uint64_t v = 0;
+	for (int i = 0; i < 8; i++) v |= (uint64_t) p[i] << (8 * i);
+	return v;
+}
+
+static unsigned char* put_varint(unsigned char* p, uint64_t v) {
+	while (v >= 0x80)
+	{
+		*p++ = (unsigned char) (v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (unsigned char) v;
+	return p;
+}
+
+/* Reads a varint, NULL if it runs past end */
+static const unsigned char* get_varint(const unsigned char* p,
+									   const unsigned char* end, uint64_t* v) {
+	*v = 0;
+	for (int shift = 0; p < end && shift < 64; shift += 7)
+	{
+		*v |= (uint64_t) (*p & 0x7f) << shift;
+		if (!(*p++ & 0x80)) return p;
+	}
+	return NULL;
+}
+
+/* Encoders: out must hold RECORD_ENCODE_MAX(n) bytes. They return the end */
+
+/* Run-length encodes a whole screen, as a keyframe */
+unsigned char* encode_key(const char* cells, int n, unsigned char* out) {
+	for (int i = 0; i < n;)
+	{
+		int run = 1;
+		while (i + run < n && cells[i + run] == cells[i]) run++;
+		out = put_varint(out, run);
+		*out++ = (unsigned char) cells[i];
+		i += run;
+	}
+	return out;
+}
+
+static unsigned char* encode_delta(const char* prev, const char* cells, int n,
+								   unsigned char* out) {
+	int i = 0;
+	while (1)
+	{
+		int start = i;
+		while (i < n && cells[i] == prev[i]) i++;
+		if (i == n) return out;
+
+		/* Extend the group over short unchanged gaps */
+		int first = i, last = i;
+		for (int j = i + 1; j < n && j - last <= DELTA_MIN_GAP; j++)
+			if (cells[j] != prev[j]) last = j;
+
+		out = put_varint(out, first - start);
+		out = put_varint(out, last - first + 1);
+		for (int j = first; j <= last; j++) *out++ = cells[j] ^ prev[j];
+		i = last + 1;
+	}
+}
+
+/* Decoders, 0 on malformed input */
+
+/* Decodes an encode_key screen of n cells */
+int decode_key(const unsigned char* p, const unsigned char* end, char* cells,
+			   int n) {
+	int i = 0;
+	while (i < n)
+	{
+		uint64_t run;
+		if (!(p = get_varint(p, end, &run)) || p >= end || run > (uint64_t) (n - i))
+			return 0;
+		memset(cells + i, *p++, run);
+		i += (int) run;
+	}
+	return p == end;
+}
+
+static int decode_delta(const unsigned char* p, const unsigned char* end,
+						char* cells, int n) {
+	int i = 0;
+	while (p < end)
+	{
+		uint64_t skip, len;
+		if (!(p = get_varint(p, end, &skip)) ||
+			!(p = get_varint(p, end, &len)) || skip > (uint64_t) (n - i) ||
+			len > (uint64_t) (n - i - skip) || len > (uint64_t) (end - p))
+			return 0;
+		i += (int) skip;
+		for (uint64_t j = 0; j < len; j++) cells[i++] ^= *p++;
+	}
+	return 1;
+}
+
+/* Writer */
+
+static void write_header(const Recorder* r, unsigned char* h,
+						 unsigned long long index_offset) {
+	memcpy(h, RECORD_MAGIC, 8);
+	put_u32(h + 8, r->width);
+	put_u32(h + 12, r->height);
+	put_u64(h + 16, r->period_ns);
+	put_u32(h + 24, r->num_frames);
+	put_u32(h + 28, RECORD_KEY_INTERVAL);
+	put_u64(h + 32, index_offset);
+}
+
+/* Creates path for width x height frames, 0 after printing an error */
+int recorder_open(Recorder* r, const char* path, int width, int height,
+				  long long period_ns) {
+	memset(r, 0, sizeof(*r));
+	r->path = path;
+	r->width = width;
+	r->height = height;
+	r->period_ns = period_ns;
+
+	int cells = width * height;
+	r->prev = mem_alloc(cells);
+	r->buf = mem_alloc(RECORD_ENCODE_MAX(cells));
+	if (!r->prev || !r->buf)
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 0;
+	}
+
+	r->f = fopen(path, "wb");
+	unsigned char h[HEADER_SIZE];
+	write_header(r, h, 0);
+	if (!r->f || fwrite(h, HEADER_SIZE, 1, r->f) != 1)
+	{
+		perror(path);
+		return 0;
+	}
+	r->pos = HEADER_SIZE;
+	return 1;
+}
+
+/* Appends a frame shown at tick, 0 after printing an error */
+int recorder_frame(Recorder* r, const char* cells, unsigned long long tick) {
+	int n = r->width * r->height;
+	int key = r->num_frames % RECORD_KEY_INTERVAL == 0;
+
+	if (r->num_frames == r->cap_frames)
+	{
+		int cap = r->cap_frames ? 2 * r->cap_frames : 1024;
+		void* p = mem_realloc(r->offsets, sizeof(*r->offsets) * cap);
+		if (!p)
+		{
+			fprintf(stderr, "Out of memory\n");
+			return 0;
+		}
+		r->offsets = p;
+		r->cap_frames = cap;
+	}
+
+	unsigned char* end = key ? encode_key(cells, n, r->buf)
+							 : encode_delta(r->prev, cells, n, r->buf);
+	size_t size = end - r->buf;
+
+	unsigned char head[24], *h = head;
+	*h++ = key ? FRAME_KEY : FRAME_DELTA;
+	h = put_varint(h, tick);
+	h = put_varint(h, size);
+
+	if (fwrite(head, h - head, 1, r->f) != 1 ||
+		(size && fwrite(r->buf, size, 1, r->f) != 1))
+	{
+		perror(r->path);
+		return 0;
+	}
+	r->offsets[r->num_frames++] = r->pos;
+	r->pos += (h - head) + size;
+	memcpy(r->prev, cells, n);
+	return 1;
+}
+
+/* Writes the index, completes the header and closes; 0 on I/O errors */
+int recorder_close(Recorder* r) {
+	int ok = r->f != NULL;
+	if (ok)
+	{
+		unsigned char h[HEADER_SIZE], off[8];
+		for (int i = 0; i < r->num_frames && ok; i++)
+		{
+			put_u64(off, r->offsets[i]);
+			ok = fwrite(off, 8, 1, r->f) == 1;
+		}
+		write_header(r, h, r->pos);
+		ok = ok && fseek(r->f, 0, SEEK_SET) == 0 &&
+			 fwrite(h, HEADER_SIZE, 1, r->f) == 1;
+		ok = fclose(r->f) == 0 && ok;
+		if (!ok) perror(r->path);
+	}
+	mem_free(r->prev);
+	mem_free(r->buf);
+	mem_free(r->offsets);
+	memset(r, 0, sizeof(*r));
+	return ok;
+}
+
+/* Reader */
+
+/* Maps a recording and checks its header and index, 0 after an error */
+int replay_open(Replay* r, const char* path) {
+	memset(r, 0, sizeof(*r));
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0)
+	{
+		perror(path);
+		if (fd >= 0) close(fd);
+		return 0;
+	}
+
+	r->size = st.st_size;
+	void* data = r->size ? mmap(NULL, r->size, PROT_READ, MAP_PRIVATE, fd, 0)
+						 : MAP_FAILED;
+	close(fd);
+	if (data == MAP_FAILED || r->size < HEADER_SIZE ||
+		memcmp(data, RECORD_MAGIC, 8) != 0)
+	{
+		fprintf(stderr, "%s: not a recording\n", path);
+		if (data != MAP_FAILED) munmap(data, r->size);
+		return 0;
+	}
+	r->data = data;
+
+	const unsigned char* h = r->data;
+	r->width = get_u32(h + 8);
+	r->height = get_u32(h + 12);
+	r->period_ns = get_u64(h + 16);
+	r->num_frames = get_u32(h + 24);
+	r->key_interval = get_u32(h + 28);
+	uint64_t index = get_u64(h + 32);
+
+	if (r->width < 1 || r->height < 1 || r->width > 1 << 15 ||
+		r->height > 1 << 15 || r->period_ns < 1 || r->key_interval < 1 ||
+		index < HEADER_SIZE ||
+		index > r->size || (r->size - index) / 8 < (uint64_t) r->num_frames)
+	{
+		fprintf(stderr, "%s: truncated or damaged recording\n", path);
+		replay_close(r);
+		return 0;
+	}
+	r->index = r->data + index;
+	return 1;
+}
+
+void replay_close(Replay* r) {
+	if (r->data) munmap((void*) r->data, r->size);
+	r->data = NULL;
+}
+
+/* Locates a frame's record through the index, NULL if it is damaged */
+static const unsigned char* replay_frame(const Replay* r, int frame,
+										 unsigned char* kind,
+										 unsigned long long* tick,
+										 uint64_t* size) {
+	if (frame < 0 || frame >= r->num_frames) return NULL;
+
+	uint64_t off = get_u64(r->index + 8 * (size_t) frame);
+	const unsigned char* end = r->index;
+	if (off < HEADER_SIZE || off >= (uint64_t) (end - r->data)) return NULL;
+
+	const unsigned char* p = r->data + off;
+	uint64_t t;
+	*kind = *p++;
+	if (!(p = get_varint(p, end, &t)) || !(p = get_varint(p, end, size)) ||
+		*size > (uint64_t) (end - p))
+		return NULL;
+	*tick = t;
+	return p;
+}
+
+/* Tick at which frame was shown, 0 if it is damaged */
+int replay_tick(const Replay* r, int frame, unsigned long long* tick) {
+	unsigned char kind;
+	uint64_t size;
+	return replay_frame(r, frame, &kind, tick, &size) != NULL;
+}
+
+/*
+ * Decodes the next frame into cells, which must hold the previous one
+ * unless the next frame is a keyframe. Returns 0 at the end of the
+ * recording or on a damaged frame.
+ */
+int replay_next(Replay* r, char* cells, unsigned long long* tick) {
+	unsigned char kind;
+	uint64_t size;
+	const unsigned char* p = replay_frame(r, r->next, &kind, tick, &size);
+	if (!p) return 0;
+
+	int n = r->width * r->height;
+	if (kind == FRAME_KEY ? !decode_key(p, p + size, cells, n)
+		: kind != FRAME_DELTA || r->next == 0 ||
+			  !decode_delta(p, p + size, cells, n))
+		return 0;
+
+	r->next++;
+	return 1;
+}
+
+/* Decodes frame into cells from the keyframe before it, 0 on failure */
+int replay_seek(Replay* r, int frame, char* cells, unsigned long long* tick) {
+	if (frame < 0 || frame >= r->num_frames) return 0;
+	r->next = frame - frame % r->key_interval;
+	while (r->next <= frame)
+		if (!replay_next(r, cells, tick)) return 0;
+	return 1;
+}
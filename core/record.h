@@ -0,0 +1,56 @@
+// record.h
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* Frames between keyframes, bounding the work of a seek */
+#define RECORD_KEY_INTERVAL 64
+
+/* Largest encoding of an n-cell frame */
+#define RECORD_ENCODE_MAX(n) (3 * (size_t) (n) + 16)
+
+/* Structures */
+
+/* Writes rendered frames to a recording file, see record.c for the format */
+typedef struct {
+	FILE* f;
+	const char* path;
+	int width, height;
+	long long period_ns; // animation time of a tick
+	char* prev;			 // last frame written
+	unsigned char* buf; // one encoded frame
+	unsigned long long* offsets;
+	int num_frames, cap_frames;
+	unsigned long long pos; // bytes written so far
+} Recorder;
+
+/* A recording mapped into memory, decoded a frame at a time */
+typedef struct {
+	const unsigned char* data;
+	size_t size;
+	int width, height;
+	long long period_ns;
+	int num_frames;
+	int key_interval;
+	const unsigned char* index;
+	int next; // frame replay_next decodes
+} Replay;
+
+/* Function Prototypes */
+unsigned char* encode_key(const char* cells, int n, unsigned char* out);
+int decode_key(const unsigned char* p, const unsigned char* end, char* cells,
+			   int n);
+int recorder_open(Recorder* r, const char* path, int width, int height,
+				  long long period_ns);
+int recorder_frame(Recorder* r, const char* cells, unsigned long long tick);
+int recorder_close(Recorder* r);
+int replay_open(Replay* r, const char* path);
+void replay_close(Replay* r);
+int replay_tick(const Replay* r, int frame, unsigned long long* tick);
+int replay_next(Replay* r, char* cells, unsigned long long* tick);
+int replay_seek(Replay* r, int frame, char* cells, unsigned long long* tick);
+
+#endif
@@ -0,0 +1,445 @@
+// render.c
+
+#include "core/render.h"
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+#include "core/alloc.h"
+#include "core/kernels.h"
+#include "core/raster.h"
+#include "core/stats.h"
+
+/*
+ * Fused rotate-project-rasterize pass over positions [begin, end) of the
+ * concatenated spans. The model-view-projection matrix is built once per
+ * frame by the caller. Points are projected a chunk at a time by the SIMD
+ * kernel and immediately depth tested, so the point buffer is read once
+ * and nothing is written back to it.
+ */
+void render_range(Frame* f, const PointsSoA* points, const PointSpan* spans,
+				  int num_spans, const Mat4* mvp, int begin, int end) {
+	int half_w = f->width / 2;
+	int half_h = f->height / 2;
+
+	int screen_x[RENDER_CHUNK], screen_y[RENDER_CHUNK];
+	real depth[RENDER_CHUNK];
+
+	int offset = 0;
+	for (int s = 0; s < num_spans && offset < end; s++)
+	{
+		/* Clip the span to the requested range */
+		int lo = begin > offset ? begin - offset : 0;
+		int hi = end - offset < spans[s].count ? end - offset : spans[s].count;
+		offset += spans[s].count;
+		if (lo >= hi) continue;
+
+		char ch = spans[s].ch;
+		int last = spans[s].first + hi;
+
+		for (int first = spans[s].first + lo; first < last; first += RENDER_CHUNK)
+		{
+			int n = last - first < RENDER_CHUNK ? last - first : RENDER_CHUNK;
+			STATS_BEGIN(t);
+			project_points(points, first, n, mvp, screen_x, screen_y, depth);
+			STATS_END(t, STATS_PROJECT);
+			STATS_BEGIN(t_depth);
+			STATS_ONLY(int offscreen = 0, written = 0;)
+
+			for (int i = 0; i < n; i++)
+			{
+				/* Map projected coordinates to screen indices */
+				int x = screen_x[i] + half_w;
+				int y = screen_y[i] + half_h;
+
+				if (x < 0 || x >= f->width || y < 0 || y >= f->height)
+				{
+					STATS_ONLY(offscreen++;)
+					continue;
+				}
+
+				/* Update if the point is closer (smaller z value) */
+				int cell = y * f->width + x;
+				if (depth[i] < f->z[cell])
+				{
+					f->z[cell] = depth[i];
+					f->cells[cell] = ch;
+					STATS_ONLY(written++;)
+				}
+			}
+			STATS_END(t_depth, STATS_DEPTH);
+			STATS_ADD(STATS_POINTS, n);
+			STATS_ADD(STATS_OFFSCREEN, offscreen);
+			STATS_ADD(STATS_REJECTED, n - offscreen - written);
+		}
+	}
+}
+
+/*
+ * Plane of a flat convex polygon through its centroid, with its area, the
+ * normal pointing away from inside
+ */
+FacePlane face_polygon(const Vec3* corners, int n, Vec3 inside) {
+	Vec3 sum = vec3(0, 0, 0), center = vec3(0, 0, 0);
+	for (int i = 0; i < n; i++)
+	{
+		sum = vec3_add(sum, vec3_cross(corners[i], corners[(i + 1) % n]));
+		center = vec3_add(center, corners[i]);
+	}
+
+	FacePlane p;
+	p.normal = vec3_normalize(sum);
+	p.point = vec3_scale(center, 1.0 / n);
+	p.area = sqrt(vec3_dot(sum, sum)) / 2;
+	if (vec3_dot(p.normal, vec3_sub(p.point, inside)) < 0)
+		p.normal = vec3_scale(p.normal, -1);
+	return p;
+}
+
+/*
+ * Cells the face would cover if it faced the camera, once transformed by
+ * model and projected with focal cells per unit at unit depth, from the
+ * camera at eye looking down +z. Foreshortening is left out: it only
+ * packs samples closer in one direction, while the other keeps its
+ * length on screen.
+ */
+double face_screen_area(const FacePlane* plane, const Mat4* model, Vec3 eye,
+						double focal) {
+	Vec4 p = mat4_mul_point(model, plane->point);
+	double z = p.z - eye.z;
+	if (z <= 0) return INFINITY;
+	return focal * focal * plane->area / (z * z);
+}
+
+/*
+ * Visibility pre-pass: copies the spans whose face points towards the eye
+ * into visible and returns how many there are. model must be a rigid
+ * transform, so that it maps normals like any other direction.
+ */
+int cull_spans(const PointSpan* spans, const FacePlane* planes, int num_spans,
+			   const Mat4* model, Vec3 eye, PointSpan* visible) {
+	int n = 0;
+	for (int s = 0; s < num_spans; s++)
+	{
+		Vec3 normal = mat4_mul_dir(model, planes[s].normal);
+		Vec4 p = mat4_mul_point(model, planes[s].point);
+
+		if (vec3_dot(normal, vec3_sub(eye, vec3(p.x, p.y, p.z))) > 0)
+			visible[n++] = spans[s];
+	}
+	return n;
+}
+
+/* Renders every point of every span */
+void render_points(Frame* f, const PointsSoA* points, const PointSpan* spans,
+				   int num_spans, const Mat4* mvp) {
+	render_range(f, points, spans, num_spans, mvp, 0, INT_MAX);
+}
+
+/* Barrier */
+static void barrier_init(Barrier* b, int count) {
+	pthread_mutex_init(&b->lock, NULL);
+	pthread_cond_init(&b->cond, NULL);
+	b->count = count;
+	b->waiting = 0;
+	b->phase = 0;
+}
+
+static void barrier_destroy(Barrier* b) {
+	pthread_mutex_destroy(&b->lock);
+	pthread_cond_destroy(&b->cond);
+}
+
+static void barrier_wait(Barrier* b) {
+	pthread_mutex_lock(&b->lock);
+	int phase = b->phase;
+	if (++b->waiting == b->count)
+	{
+		b->waiting = 0;
+		b->phase++;
+		pthread_cond_broadcast(&b->cond);
+	}
+	else
+		while (phase == b->phase) pthread_cond_wait(&b->cond, &b->lock);
+	pthread_mutex_unlock(&b->lock);
+}
+
+/* Allocates the depth and character buffers, returns 0 on failure */
+int frame_alloc(Frame* f, int width, int height) {
+	f->width = width;
+	f->height = height;
+	f->z = mem_alloc(sizeof(real) * width * height);
+	f->cells = mem_alloc(width * height);
+	return f->z && f->cells;
+}
+
+void frame_release(Frame* f) {
+	mem_free(f->z);
+	mem_free(f->cells);
+	f->z = NULL;
+	f->cells = NULL;
+}
+
+/* Rasterizes thread t's slice, then merges its share of rows */
+static void renderer_work(Renderer* r, int t) {
+	if (r->meshes)
+	{
+		/* Bands of rows are disjoint, so threads write the target directly */
+		int row_begin = r->target->height * t / r->threads;
+		int row_end = r->target->height * (t + 1) / r->threads;
+		for (int m = 0; m < r->num_meshes; m++)
+			raster_mesh(r->target, &r->meshes[m], row_begin, row_end);
+		barrier_wait(&r->barrier);
+		return;
+	}
+
+	int total = 0;
+	for (int s = 0; s < r->num_spans; s++) total += r->spans[s].count;
+
+	long begin = (long) total * t / r->threads;
+	long end = (long) total * (t + 1) / r->threads;
+
+	Frame* f = r->target;
+	if (t > 0)
+	{
+		/* Scratch buffers start empty: anything drawn beats +inf */
+		f = &r->scratch[t];
+		int cells = f->width * f->height;
+		for (int i = 0; i < cells; i++) f->z[i] = REAL_FAR;
+	}
+	render_range(f, r->points, r->spans, r->num_spans, r->mvp, (int) begin,
+				 (int) end);
+
+	barrier_wait(&r->barrier);
+
+	/* Merge in slice order; strict < keeps the earlier slice on ties */
+	int width = r->target->width;
+	int row_begin = r->target->height * t / r->threads;
+	int row_end = r->target->height * (t + 1) / r->threads;
+	for (int s = 1; s < r->threads; s++)
+	{
+		const Frame* src = &r->scratch[s];
+		for (int i = row_begin * width; i < row_end * width; i++)
+		{
+			if (src->z[i] < r->target->z[i])
+			{
+				r->target->z[i] = src->z[i];
+				r->target->cells[i] = src->cells[i];
+			}
+		}
+	}
+
+	barrier_wait(&r->barrier);
+}
+
+typedef struct {
+	Renderer* r;
+	int t;
+} WorkerArg;
+
+static void* renderer_worker(void* arg) {
+	Renderer* r = ((WorkerArg*) arg)->r;
+	int t = ((WorkerArg*) arg)->t;
+	mem_free(arg);
+
+	unsigned long seen = 0;
+	while (1)
+	{
+		pthread_mutex_lock(&r->lock);
+		while (r->generation == seen && !r->quit)
+			pthread_cond_wait(&r->wake, &r->lock);
+		seen = r->generation;
+		int quit = r->quit;
+		pthread_mutex_unlock(&r->lock);
+
+		if (quit) return NULL;
+		renderer_work(r, t);
+	}
+}
+
+/* Drops the workers from threads on, which never started */
+static void renderer_shrink(Renderer* r, int threads) {
+	for (int t = threads; t < r->threads; t++) frame_release(&r->scratch[t]);
+	r->threads = threads;
+	barrier_destroy(&r->barrier);
+	barrier_init(&r->barrier, threads);
+}
+
+/* Starts threads - 1 workers for a width x height target, 0 on failure */
+int renderer_init(Renderer* r, int threads, int width, int height) {
+	memset(r, 0, sizeof(*r));
+	r->threads = threads < 1 ? 1 : threads;
+	r->width = width;
+	r->height = height;
+
+	int ok = frame_alloc(&r->reference, width, height);
+	if (ok && r->threads == 1) return 1;
+
+	if (ok)
+	{
+		r->scratch = mem_alloc(sizeof(Frame) * r->threads);
+		r->workers = mem_alloc(sizeof(pthread_t) * r->threads);
+		ok = r->scratch && r->workers;
+	}
+	if (r->scratch) memset(r->scratch, 0, sizeof(Frame) * r->threads);
+	for (int t = 1; ok && t < r->threads; t++)
+		ok = frame_alloc(&r->scratch[t], width, height);
+	if (!ok)
+	{
+		/* No worker has started yet, so there are none to stop */
+		mem_free(r->workers);
+		r->workers = NULL;
+		renderer_free(r);
+		return 0;
+	}
+
+	barrier_init(&r->barrier, r->threads);
+	pthread_mutex_init(&r->lock, NULL);
+	pthread_cond_init(&r->wake, NULL);
+
+	for (int t = 1; t < r->threads; t++)
+	{
+		WorkerArg* arg = mem_alloc(sizeof(WorkerArg));
+		if (!arg)
+		{
+			/* Stop the threads that did start and free everything */
+			renderer_shrink(r, t);
+			renderer_free(r);
+			return 0;
+		}
+		arg->r = r;
+		arg->t = t;
+		if (pthread_create(&r->workers[t], NULL, renderer_worker, arg) != 0)
+		{
+			/* Run with the threads that did start */
+			mem_free(arg);
+			renderer_shrink(r, t);
+			break;
+		}
+	}
+	return 1;
+}
+
+/* Stops the workers and frees the scratch buffers */
+void renderer_free(Renderer* r) {
+	if (r->workers)
+	{
+		pthread_mutex_lock(&r->lock);
+		r->quit = 1;
+		pthread_cond_broadcast(&r->wake);
+		pthread_mutex_unlock(&r->lock);
+
+		for (int t = 1; t < r->threads; t++) pthread_join(r->workers[t], NULL);
+
+		barrier_destroy(&r->barrier);
+		pthread_mutex_destroy(&r->lock);
+		pthread_cond_destroy(&r->wake);
+	}
+	if (r->scratch)
+		for (int t = 1; t < r->threads; t++) frame_release(&r->scratch[t]);
+
+	frame_release(&r->reference);
+	mem_free(r->scratch);
+	mem_free(r->workers);
+	r->scratch = NULL;
+	r->workers = NULL;
+}
+
+/*
+ * Reallocates the reference and scratch buffers for a new target size.
+ * Must be called between frames. Returns 0 on failure.
+ */
+int renderer_resize(Renderer* r, int width, int height) {
+	r->width = width;
+	r->height = height;
+
+	frame_release(&r->reference);
+	int ok = frame_alloc(&r->reference, width, height);
+	if (r->scratch)
+		for (int t = 1; t < r->threads; t++)
+		{
+			frame_release(&r->scratch[t]);
+			ok = frame_alloc(&r->scratch[t], width, height) && ok;
+		}
+	return ok;
+}
+
+/* Draws the spans into target, which must match the renderer's size */
+void renderer_draw(Renderer* r, Frame* target, const PointsSoA* points,
+				   const PointSpan* spans, int num_spans, const Mat4* mvp) {
+	if (r->threads == 1)
+	{
+		render_points(target, points, spans, num_spans, mvp);
+		return;
+	}
+
+	pthread_mutex_lock(&r->lock);
+	r->target = target;
+	r->points = points;
+	r->spans = spans;
+	r->num_spans = num_spans;
+	r->mvp = mvp;
+	r->meshes = NULL;
+	r->generation++;
+	pthread_cond_broadcast(&r->wake);
+	pthread_mutex_unlock(&r->lock);
+
+	renderer_work(r, 0);
+}
+
+/*
+ * Draws like renderer_draw and also single-threaded into a copy of the
+ * target. Returns 1 if both results are bit-identical.
+ */
+int renderer_verify(Renderer* r, Frame* target, const PointsSoA* points,
+					const PointSpan* spans, int num_spans, const Mat4* mvp) {
+	int cells = target->width * target->height;
+	memcpy(r->reference.z, target->z, sizeof(real) * cells);
+	memcpy(r->reference.cells, target->cells, cells);
+
+	render_points(&r->reference, points, spans, num_spans, mvp);
+	renderer_draw(r, target, points, spans, num_spans, mvp);
+
+	return memcmp(r->reference.z, target->z, sizeof(real) * cells) == 0 &&
+		   memcmp(r->reference.cells, target->cells, cells) == 0;
+}
+
+/*
+ * Fills the triangles of already projected meshes into target, in order:
+ * one job for all of them, however many there are
+ */
+void renderer_draw_meshes(Renderer* r, Frame* target, const Mesh* meshes,
+						  int num_meshes) {
+	if (r->threads == 1)
+	{
+		for (int m = 0; m < num_meshes; m++)
+			raster_mesh(target, &meshes[m], 0, target->height);
+		return;
+	}
+
+	pthread_mutex_lock(&r->lock);
+	r->target = target;
+	r->meshes = meshes;
+	r->num_meshes = num_meshes;
+	r->generation++;
+	pthread_cond_broadcast(&r->wake);
+	pthread_mutex_unlock(&r->lock);
+
+	renderer_work(r, 0);
+}
+
+/* renderer_verify for meshes: threaded bands against one full pass */
+int renderer_verify_meshes(Renderer* r, Frame* target, const Mesh* meshes,
+						   int num_meshes) {
+	int cells = target->width * target->height;
+	memcpy(r->reference.z, target->z, sizeof(real) * cells);
+	memcpy(r->reference.cells, target->cells, cells);
+
+	for (int m = 0; m < num_meshes; m++)
+		raster_mesh(&r->reference, &meshes[m], 0, target->height);
+	renderer_draw_meshes(r, target, meshes, num_meshes);
+
+	return memcmp(r->reference.z, target->z, sizeof(real) * cells) == 0 &&
+		   memcmp(r->reference.cells, target->cells, cells) == 0;
+}
@@ -0,0 +1,98 @@
+// render.h
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <pthread.h>
+
+#include "core/linalg.h"
+#include "core/mesh.h"
+#include "core/points.h"
+
+/* Points projected per kernel call; the chunk's outputs stay in L1 */
+#define RENDER_CHUNK 256
+
+/* Structures */
+
+/* Depth and character buffers of one frame, row-major */
+typedef struct {
+	real* z; // depth in the point precision, see points.h
+	char* cells;
+	int width, height;
+} Frame;
+
+/* A run of consecutive points drawn with the same character */
+typedef struct {
+	int first, count;
+	char ch;
+} PointSpan;
+
+/* Plane of a face: outward unit normal and a point on it, model space */
+typedef struct {
+	Vec3 normal;
+	Vec3 point;
+	double area; // of the face, for level of detail; 0 if unknown
+} FacePlane;
+
+/* Reusable barrier for the renderer's worker threads */
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	int count, waiting, phase;
+} Barrier;
+
+/*
+ * Multithreaded renderer. For points, each thread rasterizes a contiguous
+ * slice of the points into its own depth buffer, then the buffers are
+ * merged in slice order. Ties keep the earlier slice, which is exactly
+ * what the single-threaded pass does, so the output is bit-identical.
+ * For meshes, each thread fills its own band of rows of the target with
+ * every triangle of every mesh, which needs no merge at all.
+ */
+typedef struct {
+	int threads;
+	int width, height;
+	Frame* scratch; // one per worker thread, thread 0 draws into the target
+	Frame reference; // single-threaded result for renderer_verify
+	pthread_t* workers;
+	Barrier barrier;
+
+	/* Current job, published under lock */
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	unsigned long generation;
+	int quit;
+	Frame* target;
+	const PointsSoA* points;
+	const PointSpan* spans;
+	int num_spans;
+	const Mat4* mvp;
+	const Mesh* meshes; // set for a mesh job, NULL for points
+	int num_meshes;
+} Renderer;
+
+/* Function Prototypes */
+FacePlane face_polygon(const Vec3* corners, int n, Vec3 inside);
+double face_screen_area(const FacePlane* plane, const Mat4* model, Vec3 eye,
+						double focal);
+int cull_spans(const PointSpan* spans, const FacePlane* planes, int num_spans,
+			   const Mat4* model, Vec3 eye, PointSpan* visible);
+int frame_alloc(Frame* f, int width, int height);
+void frame_release(Frame* f);
+void render_points(Frame* f, const PointsSoA* points, const PointSpan* spans,
+				   int num_spans, const Mat4* mvp);
+void render_range(Frame* f, const PointsSoA* points, const PointSpan* spans,
+				  int num_spans, const Mat4* mvp, int begin, int end);
+int renderer_init(Renderer* r, int threads, int width, int height);
+void renderer_free(Renderer* r);
+int renderer_resize(Renderer* r, int width, int height);
+void renderer_draw(Renderer* r, Frame* target, const PointsSoA* points,
+				   const PointSpan* spans, int num_spans, const Mat4* mvp);
+int renderer_verify(Renderer* r, Frame* target, const PointsSoA* points,
+					const PointSpan* spans, int num_spans, const Mat4* mvp);
+void renderer_draw_meshes(Renderer* r, Frame* target, const Mesh* meshes,
+						  int num_meshes);
+int renderer_verify_meshes(Renderer* r, Frame* target, const Mesh* meshes,
+						   int num_meshes);
+
+#endif
@@ -0,0 +1,58 @@
+// scene.c
+
+#include "core/scene.h"
+
+#include <string.h>
+
+#include "core/alloc.h"
+
+void scene_init(Scene* sc) { memset(sc, 0, sizeof(*sc)); }
+
+void scene_free(Scene* sc) {
+	for (int i = 0; i < sc->num_shapes; i++) mesh_free(&sc->shapes[i]);
+	mem_free(sc->shapes);
+	mem_free(sc->objects);
+	scene_init(sc);
+}
+
+/*
+ * Takes ownership of mesh, leaving it empty, and fits it to the unit
+ * sphere. The triangles must be wound outward. Returns the shape's index,
+ * -1 on failure.
+ */
+int scene_add_shape(Scene* sc, Mesh* mesh) {
+	if (!mem_grow((void**) &sc->shapes, &sc->shape_cap, sc->num_shapes + 1,
+				  sizeof(Mesh)))
+		return -1;
+	mesh_fit(mesh, vec3(0, 0, 0), 1);
+	sc->shapes[sc->num_shapes] = *mesh;
+	memset(mesh, 0, sizeof(*mesh));
+	return sc->num_shapes++;
+}
+
+/* Places shape at position with the given size, returns 0 on failure */
+int scene_add_object(Scene* sc, int shape, Vec3 position, double radius,
+					 Quat rotation) {
+	if (!mem_grow((void**) &sc->objects, &sc->object_cap, sc->num_objects + 1,
+				  sizeof(SceneObject)))
+		return 0;
+	SceneObject o = {shape, position, radius, rotation};
+	sc->objects[sc->num_objects++] = o;
+	return 1;
+}
+
+/* Vertices over every object, as if each had its own copy of its shape */
+long scene_num_verts(const Scene* sc) {
+	long n = 0;
+	for (int i = 0; i < sc->num_objects; i++)
+		n += sc->shapes[sc->objects[i].shape].num_verts;
+	return n;
+}
+
+/* Triangles over every object */
+long scene_num_tris(const Scene* sc) {
+	long n = 0;
+	for (int i = 0; i < sc->num_objects; i++)
+		n += sc->shapes[sc->objects[i].shape].num_tris;
+	return n;
+}
@@ -0,0 +1,41 @@
+// scene.h
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "core/linalg.h"
+#include "core/mesh.h"
+
+/* Structures */
+
+/* One placement of a shape: its centre, size and resting rotation */
+typedef struct {
+	int shape;
+	Vec3 position; // world space
+	double radius; // of the bounding sphere, world units
+	Quat rotation; // applied before the scene's spin
+} SceneObject;
+
+/*
+ * Many objects drawn into one frame. Shapes are shared, read-only
+ * geometry fitted to the unit sphere about the origin; each object
+ * places one of them, so a shape is stored once however many times it
+ * is drawn.
+ */
+typedef struct {
+	Mesh* shapes;
+	int num_shapes, shape_cap;
+	SceneObject* objects;
+	int num_objects, object_cap;
+} Scene;
+
+/* Function Prototypes */
+void scene_init(Scene* sc);
+void scene_free(Scene* sc);
+int scene_add_shape(Scene* sc, Mesh* mesh);
+int scene_add_object(Scene* sc, int shape, Vec3 position, double radius,
+					 Quat rotation);
+long scene_num_verts(const Scene* sc);
+long scene_num_tris(const Scene* sc);
+
+#endif
@@ -0,0 +1,87 @@
+// sched.c
+
+#include "core/sched.h"
+
+#include <errno.h>
+#include <time.h>
+
+/* Monotonic time in nanoseconds */
+static long long now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Sleeps until the monotonic clock reaches t */
+static void sleep_until(long long t) {
+	struct timespec ts = {t / 1000000000LL, t % 1000000000LL};
+#ifdef TIMER_ABSTIME
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+		;
+#else
+	/* No absolute sleep: fall back to a relative one, rechecking the clock */
+	long long left;
+	while ((left = t - now_ns()) > 0)
+	{
+		struct timespec rel = {left / 1000000000LL, left % 1000000000LL};
+		nanosleep(&rel, NULL);
+	}
+	(void) ts;
+#endif
+}
+
+/* Starts the clock at tick 0 */
+void sched_init(Scheduler* s, double fps, SchedPolicy policy) {
+	s->period_ns = (long long) (1e9 / fps + 0.5);
+	if (s->period_ns < 1) s->period_ns = 1;
+	s->start_ns = now_ns();
+	s->tick = 0;
+	s->policy = policy;
+	s->late = 0;
+	s->skipped = 0;
+}
+
+/* Animation time of a tick, in seconds */
+double sched_tick_time(const Scheduler* s, unsigned long long tick) {
+	return tick * (s->period_ns * 1e-9);
+}
+
+/*
+ * Blocks until the next tick is due and returns it. Ticks whose deadline
+ * has already passed are either dropped or rendered without sleeping,
+ * depending on the policy.
+ */
+unsigned long long sched_wait(Scheduler* s) {
+	unsigned long long next = s->tick + 1;
+	long long now = now_ns();
+	long long due = s->start_ns + (long long) next * s->period_ns;
+
+	if (now < due)
+	{
+		sleep_until(due);
+		s->tick = next;
+		return next;
+	}
+
+	/* Overrun: the latest tick whose deadline has passed */
+	unsigned long long latest = (now - s->start_ns) / s->period_ns;
+	if (s->policy == SCHED_CATCHUP && latest - next < SCHED_MAX_BEHIND)
+	{
+		s->late++;
+		s->tick = next;
+		return next;
+	}
+
+	s->skipped += latest - next;
+	s->late++;
+	s->tick = latest;
+	return latest;
+}
+
+/* Blocks until tick is due, for replaying frames recorded at known ticks */
+void sched_wait_tick(Scheduler* s, unsigned long long tick) {
+	long long due = s->start_ns + (long long) tick * s->period_ns;
+	if (now_ns() < due) sleep_until(due);
+	else if (tick > s->tick) s->late++;
+	s->tick = tick;
+}
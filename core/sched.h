@@ -0,0 +1,38 @@
+// sched.h
+
+#ifndef SCHED_H
+#define SCHED_H
+
+/* What to do when a frame misses its deadline */
+typedef enum {
+	SCHED_SKIP,	   // drop the missed ticks and render the latest one
+	SCHED_CATCHUP, // render every missed tick back to back
+} SchedPolicy;
+
+/* Ticks a catching-up scheduler may fall behind before it skips anyway */
+#define SCHED_MAX_BEHIND 8
+
+/* Structures */
+
+/*
+ * Fixed-timestep frame scheduler. Tick k is due at start + k * period on
+ * the monotonic clock, so the pacing never accumulates the render time
+ * and the animation time of a tick (k * period) does not depend on how
+ * fast the machine is.
+ */
+typedef struct {
+	long long period_ns;
+	long long start_ns;
+	unsigned long long tick; // tick being rendered
+	SchedPolicy policy;
+	unsigned long late;	   // ticks rendered after their deadline
+	unsigned long skipped; // ticks never rendered
+} Scheduler;
+
+/* Function Prototypes */
+void sched_init(Scheduler* s, double fps, SchedPolicy policy);
+double sched_tick_time(const Scheduler* s, unsigned long long tick);
+unsigned long long sched_wait(Scheduler* s);
+void sched_wait_tick(Scheduler* s, unsigned long long tick);
+
+#endif
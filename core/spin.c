@@ -0,0 +1,490 @@
+// spin.c
+
+#include "core/spin.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "core/alloc.h"
+#include "core/raster.h"
+#include "core/stats.h"
+
+/* Screen-space scale that fits the layout size into width x height */
+static double layout_scale(int width, int height) {
+	double sx = (double) width / SPIN_LAYOUT_WIDTH;
+	double sy = (double) height / SPIN_LAYOUT_HEIGHT;
+	return sx < sy ? sx : sy;
+}
+
+/* Folds the screen-space scale into the view-projection matrix */
+static void spin_update_proj(Spin* s) {
+	s->proj = mat4_mul(mat4_scale(vec3(s->scale, s->scale, 1)), s->view_proj);
+}
+
+/* Starts a context with an empty scene, returns 0 on failure */
+int spin_init(Spin* s, int threads, int width, int height) {
+	memset(s, 0, sizeof(*s));
+	s->orientation = quat_identity();
+	s->cull = 1;
+	s->lod = 1;
+	spin_set_camera(s, 40, 120, vec3(0, 0, 0), vec3(0, 0, 75));
+
+	s->drawn = mem_alloc(sizeof(Mesh));
+	return s->drawn && renderer_init(&s->renderer, threads, width, height) &&
+		   spin_resize(s, width, height);
+}
+
+/* Frees the buffers, the workers and the scene */
+void spin_free(Spin* s) {
+	renderer_free(&s->renderer);
+	mesh_free(&s->mesh);
+	scene_free(&s->objects);
+	points_free(&s->points);
+	mem_free(s->z);
+	mem_free(s->spans);
+	mem_free(s->planes);
+	mem_free(s->visible);
+	mem_free(s->selected);
+	mem_free(s->drawn);
+	mem_free(s->screens);
+	mem_free(s->shaded);
+	s->drawn = NULL;
+	s->screens = NULL;
+	s->shaded = NULL;
+	s->z = NULL;
+	s->spans = s->visible = s->selected = NULL;
+	s->planes = NULL;
+	s->num_spans = 0;
+}
+
+/* Reallocates for a new frame size between frames, returns 0 on failure */
+int spin_resize(Spin* s, int width, int height) {
+	mem_free(s->z);
+	s->width = width;
+	s->height = height;
+	s->scale = layout_scale(width, height);
+	spin_update_proj(s);
+	s->z = mem_alloc(sizeof(real) * width * height);
+	return s->z && renderer_resize(&s->renderer, width, height);
+}
+
+/* Perspective camera at eye looking down +z; the model turns about center */
+void spin_set_camera(Spin* s, double near_dst, double far_dst, Vec3 eye,
+					 Vec3 center) {
+	s->near_dst = near_dst;
+	s->far_dst = far_dst;
+	s->eye = eye;
+	s->center = center;
+	s->view_proj = mat4_mul(mat4_projection(near_dst, far_dst),
+							mat4_translate(vec3_scale(eye, -1)));
+	spin_update_proj(s);
+}
+
+/*
+ * Normals and a copy of the triangles for a lit mesh: the copy is shaded
+ * each frame, so the mesh keeps its own characters. Returns 0 on failure.
+ */
+static int spin_light_mesh(Spin* s) {
+	mem_free(s->shaded);
+	s->shaded = NULL;
+	if (!s->lit || s->mesh.num_tris == 0) return 1;
+
+	s->shaded = mem_alloc(sizeof(Triangle) * s->mesh.num_tris);
+	if (!s->shaded) return 0;
+	memcpy(s->shaded, s->mesh.tris, sizeof(Triangle) * s->mesh.num_tris);
+	return mesh_compute_normals(&s->mesh);
+}
+
+/* Takes ownership of mesh, leaving it empty. Returns 0 on failure */
+int spin_set_mesh(Spin* s, Mesh* mesh) {
+	mesh_free(&s->mesh);
+	s->mesh = *mesh;
+	memset(mesh, 0, sizeof(*mesh));
+	return spin_light_mesh(s);
+}
+
+/*
+ * Takes ownership of objects, leaving it empty: from now on they are drawn
+ * along with the mesh, in faces mode. Objects keep their shapes'
+ * characters; lighting only shades the mesh. Returns 0 on failure.
+ */
+int spin_set_objects(Spin* s, Scene* objects) {
+	scene_free(&s->objects);
+	s->objects = *objects;
+	scene_init(objects);
+
+	mem_free(s->drawn);
+	mem_free(s->screens);
+	s->drawn = mem_alloc(sizeof(Mesh) * (s->objects.num_objects + 1));
+	s->screens = mem_alloc(sizeof(Vec3) * scene_num_verts(&s->objects));
+	return s->drawn && (s->screens || s->objects.num_objects == 0);
+}
+
+/*
+ * Takes ownership of points, leaving it empty, and copies the spans and
+ * their face planes. spans holds levels sets of num_spans, one per face,
+ * from the coarsest density up; with SPIN_LOD_LEVELS of them the density
+ * follows each face's size on screen, otherwise the finest is drawn.
+ * Returns 0 on failure.
+ */
+int spin_set_points(Spin* s, PointsSoA* points, const PointSpan* spans,
+					const FacePlane* planes, int num_spans, int levels) {
+	points_free(&s->points);
+	s->points = *points;
+	memset(points, 0, sizeof(*points));
+
+	if (num_spans != s->num_spans || levels != s->lod_levels)
+	{
+		mem_free(s->spans);
+		mem_free(s->planes);
+		mem_free(s->visible);
+		mem_free(s->selected);
+		s->spans = mem_alloc(sizeof(PointSpan) * num_spans * levels);
+		s->planes = mem_alloc(sizeof(FacePlane) * num_spans);
+		s->visible = mem_alloc(sizeof(PointSpan) * num_spans);
+		s->selected = mem_alloc(sizeof(PointSpan) * num_spans);
+		s->num_spans = num_spans;
+		s->lod_levels = levels;
+		if (!s->spans || !s->planes || !s->visible || !s->selected)
+		{
+			s->num_spans = s->lod_levels = 0;
+			return 0;
+		}
+	}
+	memcpy(s->spans, spans, sizeof(PointSpan) * num_spans * levels);
+	memcpy(s->planes, planes, sizeof(FacePlane) * num_spans);
+	return 1;
+}
+
+/* Points along an edge at a level, for nominal points at the nominal one */
+static int spin_lod_edge(double nominal, int level) {
+	int n = (int) (nominal * pow(2, (level - SPIN_LOD_NOMINAL) / 2.0) + 0.5);
+	return n < 2 ? 2 : n;
+}
+
+/*
+ * Samples num_faces faces into points at every level of detail, with
+ * nominal points along an edge at the nominal level, so small frames don't
+ * sample many points per cell. Each face is a contiguous run of points
+ * with its character from chars; spans gets one set of them per level,
+ * coarsest first. sample writes face's points for edge points along an
+ * edge from index first and returns the index after them; given no
+ * points, it only counts them. Returns 0 on failure.
+ */
+int spin_sample_faces(PointsSoA* points, PointSpan* spans, int num_faces,
+					  const char* chars, double nominal,
+					  int (*sample)(PointsSoA* points, int first, int face,
+									int edge, void* user),
+					  void* user) {
+	int edge[SPIN_LOD_LEVELS], total = 0;
+	for (int l = 0; l < SPIN_LOD_LEVELS; l++)
+	{
+		edge[l] = spin_lod_edge(nominal, l);
+		for (int f = 0; f < num_faces; f++)
+			total = sample(NULL, total, f, edge[l], user);
+	}
+
+	points_free(points);
+	if (!points_init(points, total)) return 0;
+
+	int first = 0;
+	for (int l = 0; l < SPIN_LOD_LEVELS; l++)
+	{
+		for (int f = 0; f < num_faces; f++)
+		{
+			PointSpan* span = &spans[l * num_faces + f];
+			span->first = first;
+			first = sample(points, first, f, edge[l], user);
+			span->count = first - span->first;
+			span->ch = chars[f];
+		}
+	}
+	return 1;
+}
+
+/* Level drawn without level of detail */
+static int spin_nominal_level(const Spin* s) {
+	return s->lod_levels == SPIN_LOD_LEVELS ? SPIN_LOD_NOMINAL
+											: s->lod_levels - 1;
+}
+
+/* Points of the scene at its nominal density, for reports */
+long spin_nominal_points(const Spin* s) {
+	int level = spin_nominal_level(s);
+	long n = 0;
+	for (int f = 0; f < s->num_spans; f++)
+		n += s->spans[level * s->num_spans + f].count;
+	return n;
+}
+
+/*
+ * Level of detail: each face takes the coarsest density that still puts
+ * SPIN_LOD_DENSITY samples on every cell it would cover facing the
+ * camera, this frame.
+ */
+static void spin_select_lod(Spin* s, const Mat4* model) {
+	int fixed = spin_nominal_level(s);
+	int lod = s->lod && s->lod_levels == SPIN_LOD_LEVELS;
+	double focal = s->near_dst * s->scale;
+
+	for (int f = 0; f < s->num_spans; f++)
+	{
+		int level = fixed;
+		if (lod && s->planes[f].area > 0)
+		{
+			double cells =
+				face_screen_area(&s->planes[f], model, s->eye, focal);
+			level = 0;
+			while (level < s->lod_levels - 1 &&
+				   s->spans[level * s->num_spans + f].count <
+					   SPIN_LOD_DENSITY * cells)
+				level++;
+		}
+		s->selected[f] = s->spans[level * s->num_spans + f];
+	}
+}
+
+void spin_set_orientation(Spin* s, Quat q) { s->orientation = q; }
+
+/*
+ * Lights the faces from direction (x, y, z) in world space: y points down
+ * the screen and -z towards the viewer. Each face then takes the
+ * SPIN_RAMP character of its Lambertian brightness in place of its own
+ * character, which a zero vector, turning lighting off, brings back.
+ * Returns 0 on failure.
+ */
+int spin_set_light(Spin* s, double x, double y, double z) {
+	Vec3 l = vec3(x, y, z);
+	s->lit = vec3_dot(l, l) > 0;
+	s->light = vec3_normalize(l);
+	return spin_light_mesh(s);
+}
+
+/* Ramp character for a unit normal lit from the model-space light */
+static char spin_shade(Vec3 normal, Vec3 light) {
+	static const char ramp[] = SPIN_RAMP;
+	const int levels = sizeof(ramp) - 1;
+
+	double lum = vec3_dot(normal, light);
+	if (lum <= 0) return ramp[0];
+	return ramp[(int) (lum * (levels - 1) + 0.5)];
+}
+
+/*
+ * Lambertian shading, once per face per frame: the light is turned into
+ * model space by the inverse (transposed) rotation, so the stored face
+ * normals are used as they are. The characters go to the per-frame copies
+ * of the triangles and spans, never to the scene's own.
+ */
+static void spin_light_faces(Spin* s, const Mat3* r) {
+	Vec3 l = s->light;
+	Vec3 light = vec3(r->m[0][0] * l.x + r->m[1][0] * l.y + r->m[2][0] * l.z,
+					  r->m[0][1] * l.x + r->m[1][1] * l.y + r->m[2][1] * l.z,
+					  r->m[0][2] * l.x + r->m[1][2] * l.y + r->m[2][2] * l.z);
+
+	if (s->raster == RASTER_FACES)
+		for (int t = 0; t < s->mesh.num_tris; t++)
+			s->shaded[t].ch = spin_shade(s->mesh.normals[t], light);
+	else
+		for (int i = 0; i < s->num_spans; i++)
+			s->selected[i].ch = spin_shade(s->planes[i].normal, light);
+}
+
+/*
+ * Frustum test: 1 unless the sphere lies wholly before the near plane,
+ * beyond the far plane, or beside the frame
+ */
+static int spin_sphere_visible(const Spin* s, Vec3 center, double radius) {
+	Vec3 c = vec3_sub(center, s->eye);
+	if (c.z + radius < s->near_dst || c.z - radius > s->far_dst) return 0;
+
+	/* Side planes through the eye: focal * x = half * z at the edge */
+	double focal = s->near_dst * s->scale;
+	double half_w = s->width / 2 + 1, half_h = s->height / 2 + 1;
+	double nw = sqrt(focal * focal + half_w * half_w);
+	double nh = sqrt(focal * focal + half_h * half_h);
+	return fabs(c.x) * focal - c.z * half_w <= radius * nw &&
+		   fabs(c.y) * focal - c.z * half_h <= radius * nh;
+}
+
+/*
+ * Projects the mesh and every object in view into drawn. An object shares
+ * its shape's vertices and triangles and only gets its own projected
+ * vertices, so objects never copy geometry.
+ */
+static void spin_project_meshes(Spin* s) {
+	s->num_drawn = s->objects_drawn = 0;
+	if (s->mesh.num_tris)
+	{
+		raster_project(&s->mesh, &s->mvp, s->width, s->height);
+		s->drawn[s->num_drawn] = s->mesh;
+		if (s->lit) s->drawn[s->num_drawn].tris = s->shaded;
+		s->num_drawn++;
+	}
+
+	Vec3* screen = s->screens;
+	for (int i = 0; i < s->objects.num_objects; i++)
+	{
+		const SceneObject* o = &s->objects.objects[i];
+		Mesh m = s->objects.shapes[o->shape];
+		m.screen = screen;
+		m.cull = s->cull;
+		screen += m.num_verts;
+		if (!spin_sphere_visible(s, o->position, o->radius)) continue;
+
+		/* Scale to size, turn in place, then move into position */
+		Mat3 r = quat_to_mat3(quat_mul(s->orientation, o->rotation));
+		Mat4 model = mat4_identity();
+		for (int a = 0; a < 3; a++)
+		{
+			for (int b = 0; b < 3; b++) model.m[a][b] = r.m[a][b] * o->radius;
+		}
+		model.m[0][3] = o->position.x;
+		model.m[1][3] = o->position.y;
+		model.m[2][3] = o->position.z;
+
+		Mat4 mvp = mat4_mul(s->proj, model);
+		raster_project(&m, &mvp, s->width, s->height);
+		s->drawn[s->num_drawn++] = m;
+		s->objects_drawn++;
+	}
+}
+
+/* Composes the frame's matrices, picks point densities and culls */
+void spin_prepare(Spin* s) {
+	STATS_BEGIN(t);
+	Mat3 r = quat_to_mat3(s->orientation);
+	Mat4 model = mat4_rotate_about(&r, s->center);
+	s->mvp = mat4_mul(s->proj, model);
+	if (s->num_spans) spin_select_lod(s, &model);
+	if (s->lit) spin_light_faces(s, &r);
+
+	if (s->raster == RASTER_POINTS && s->cull)
+		s->num_visible = cull_spans(s->selected, s->planes, s->num_spans,
+									&model, s->eye, s->visible);
+	else if (s->num_spans)
+	{
+		memcpy(s->visible, s->selected, sizeof(PointSpan) * s->num_spans);
+		s->num_visible = s->num_spans;
+	}
+	s->mesh.cull = s->cull;
+	STATS_END(t, STATS_ROTATE);
+	if (s->raster == RASTER_FACES) spin_project_meshes(s);
+	else s->num_drawn = s->objects_drawn = 0;
+}
+
+/* Target for one frame; depth may be NULL to use the context's buffer */
+static Frame spin_frame(Spin* s, char* cells, real* depth) {
+	Frame f = {depth ? depth : s->z, cells, s->width, s->height};
+	return f;
+}
+
+/* Resets the depth buffer to the far plane and cells to blanks */
+void spin_clear(Spin* s, char* cells, real* depth) {
+	real* z = depth ? depth : s->z;
+	real far_z = real_from_double(s->far_dst);
+	int n = s->width * s->height;
+	for (int i = 0; i < n; i++)
+	{
+		z[i] = far_z;
+		cells[i] = ' ';
+	}
+}
+
+/* Draws the prepared frame into cells */
+void spin_draw(Spin* s, char* cells, real* depth) {
+	Frame f = spin_frame(s, cells, depth);
+	if (s->raster == RASTER_FACES)
+		renderer_draw_meshes(&s->renderer, &f, s->drawn, s->num_drawn);
+	else
+		renderer_draw(&s->renderer, &f, &s->points, s->visible, s->num_visible,
+					  &s->mvp);
+}
+
+/* Prepares, clears and draws a whole frame into cells */
+void spin_render(Spin* s, char* cells, real* depth) {
+	spin_prepare(s);
+	spin_clear(s, cells, depth);
+	spin_draw(s, cells, depth);
+}
+
+/* spin_draw, checked against a single-threaded pass; 1 if identical */
+int spin_verify(Spin* s, char* cells, real* depth) {
+	Frame f = spin_frame(s, cells, depth);
+	if (s->raster == RASTER_FACES)
+		return renderer_verify_meshes(&s->renderer, &f, s->drawn,
+									  s->num_drawn);
+	return renderer_verify(&s->renderer, &f, &s->points, s->visible,
+						   s->num_visible, &s->mvp);
+}
+
+/* Allocates and starts a context, NULL on failure */
+Spin* spin_new(int threads, int width, int height) {
+	Spin* s = mem_alloc(sizeof(Spin));
+	if (!s) return NULL;
+	if (!spin_init(s, threads, width, height))
+	{
+		mem_free(s);
+		return NULL;
+	}
+	return s;
+}
+
+/* Frees a context from spin_new */
+void spin_delete(Spin* s) {
+	if (!s) return;
+	spin_free(s);
+	mem_free(s);
+}
+
+/* Camera at the origin; the model turns about (0, 0, center_z) */
+void spin_set_view(Spin* s, double near_dst, double far_dst, double center_z) {
+	spin_set_camera(s, near_dst, far_dst, vec3(0, 0, 0),
+					vec3(0, 0, center_z));
+}
+
+/*
+ * Replaces the scene with a mesh: num_verts xyz triples, num_tris index
+ * triples and one character per triangle. The triangles keep their
+ * winding, which culling takes to be counter-clockwise from outside; see
+ * spin_orient_outward for convex meshes wound any way. Returns 0 on
+ * failure.
+ */
+int spin_set_triangles(Spin* s, const double* verts, int num_verts,
+					   const int* tris, const char* chars, int num_tris) {
+	Mesh mesh;
+	if (!mesh_init(&mesh, num_verts, num_tris)) return 0;
+	for (int i = 0; i < num_verts; i++)
+		mesh.verts[i] = vec3(verts[3 * i], verts[3 * i + 1], verts[3 * i + 2]);
+	for (int t = 0; t < num_tris; t++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			int v = tris[3 * t + k];
+			if (v < 0 || v >= num_verts)
+			{
+				mesh_free(&mesh);
+				return 0;
+			}
+			mesh.tris[t].v[k] = v;
+		}
+		mesh.tris[t].ch = chars[t];
+	}
+	s->raster = RASTER_FACES;
+	return spin_set_mesh(s, &mesh);
+}
+
+/*
+ * Winds the mesh's triangles outward from the centre of rotation. Only
+ * right for a convex mesh: a concave one, like a torus, must be given
+ * wound outward. Returns 0 on failure.
+ */
+int spin_orient_outward(Spin* s) {
+	mesh_orient_outward(&s->mesh, s->center);
+	return spin_light_mesh(s);
+}
+
+/* Orientation from Euler angles about x, y and z, in radians */
+void spin_set_angles(Spin* s, double a, double b, double c) {
+	spin_set_orientation(s, quat_from_euler(a, b, c));
+}
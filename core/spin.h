@@ -0,0 +1,121 @@
+// spin.h
+
+#ifndef SPIN_H
+#define SPIN_H
+
+#include "core/linalg.h"
+#include "core/mesh.h"
+#include "core/points.h"
+#include "core/render.h"
+#include "core/scene.h"
+
+/* Frame size the scenes are laid out for; other sizes are scaled to fit */
+#define SPIN_LAYOUT_WIDTH 170
+#define SPIN_LAYOUT_HEIGHT 40
+
+/* Luminance ramp for lit faces, darkest to brightest */
+#define SPIN_RAMP ".,-~:;=!*#$@"
+
+/*
+ * Point densities of a face for level of detail, coarsest first, each
+ * sqrt(2) times the previous along an edge. Level SPIN_LOD_NOMINAL is
+ * the scene's own density, the one drawn without level of detail.
+ */
+#define SPIN_LOD_LEVELS 6
+#define SPIN_LOD_NOMINAL 4
+
+/* Samples per covered cell a face's level must reach, against holes */
+#define SPIN_LOD_DENSITY 1.5
+
+/* How the shapes are drawn */
+typedef enum {
+	RASTER_FACES,  // scanline fill of the projected face triangles
+	RASTER_POINTS, // splat points sampled on the faces
+} RasterMode;
+
+/* Structures */
+
+/*
+ * Rendering context: one scene (a mesh and/or sampled points, plus any
+ * number of placed objects drawn with the mesh), a camera, an orientation
+ * and the buffers to draw them at one frame size. Frames
+ * are drawn into a character grid owned by the caller, row-major, and
+ * optionally a depth grid of the same shape; without one the context's
+ * own depth buffer is used.
+ *
+ * Contexts share no mutable state: any number of them may render at once
+ * from different threads, as long as each is used by one thread at a time.
+ */
+typedef struct {
+	int width, height;
+	double scale; // screen-space scale from the layout size
+	real* z;	  // depth buffer, width x height
+	Renderer renderer;
+	RasterMode raster;
+	int cull;
+	int lod;	// pick each face's point density from its size on screen
+	int lit;	// shade faces from light instead of their own characters
+	Vec3 light; // unit vector towards the light, world space
+
+	/* Scene */
+	double near_dst, far_dst;
+	Vec3 eye, center;
+	Mat4 view_proj;
+	Mat4 proj; // view_proj with the screen-space scale
+	Mesh mesh;
+	Scene objects; // faces only, each turned by the orientation in place
+	PointsSoA points;
+	PointSpan* spans; // lod_levels sets of num_spans, coarsest first
+	FacePlane* planes;
+	int num_spans, lod_levels;
+	Quat orientation;
+
+	/* Per-frame state, from spin_prepare */
+	Mat4 mvp;
+	PointSpan* selected; // each face at its chosen density
+	PointSpan* visible;
+	int num_visible;
+	Mesh* drawn;	  // the mesh and the objects in view, projected
+	int num_drawn;	  // counting the mesh, if it has triangles
+	int objects_drawn; // of those, scene objects
+	Vec3* screens;	  // projected vertices of every object
+	Triangle* shaded; // the mesh's triangles with lit characters, if lit
+} Spin;
+
+/* Function Prototypes */
+int spin_init(Spin* s, int threads, int width, int height);
+void spin_free(Spin* s);
+int spin_resize(Spin* s, int width, int height);
+void spin_set_camera(Spin* s, double near_dst, double far_dst, Vec3 eye,
+					 Vec3 center);
+int spin_set_mesh(Spin* s, Mesh* mesh);
+int spin_set_objects(Spin* s, Scene* objects);
+int spin_set_points(Spin* s, PointsSoA* points, const PointSpan* spans,
+					const FacePlane* planes, int num_spans, int levels);
+int spin_sample_faces(PointsSoA* points, PointSpan* spans, int num_faces,
+					  const char* chars, double nominal,
+					  int (*sample)(PointsSoA* points, int first, int face,
+									int edge, void* user),
+					  void* user);
+long spin_nominal_points(const Spin* s);
+void spin_set_orientation(Spin* s, Quat q);
+int spin_set_light(Spin* s, double x, double y, double z);
+void spin_prepare(Spin* s);
+void spin_clear(Spin* s, char* cells, real* depth);
+void spin_draw(Spin* s, char* cells, real* depth);
+void spin_render(Spin* s, char* cells, real* depth);
+int spin_verify(Spin* s, char* cells, real* depth);
+
+/*
+ * Handle API for embedding, e.g. through ctypes from Python: plain
+ * arguments only, no struct layouts. Set the camera before the triangles.
+ */
+Spin* spin_new(int threads, int width, int height);
+void spin_delete(Spin* s);
+void spin_set_view(Spin* s, double near_dst, double far_dst, double center_z);
+int spin_set_triangles(Spin* s, const double* verts, int num_verts,
+					   const int* tris, const char* chars, int num_tris);
+int spin_orient_outward(Spin* s);
+void spin_set_angles(Spin* s, double a, double b, double c);
+
+#endif
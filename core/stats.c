@@ -0,0 +1,129 @@
+// stats.c
+
+#include "core/stats.h"
+
+#include <string.h>
+
+/* A window closes after this long */
+#define STATS_PERIOD_NS 1000000000LL
+
+StatsTotals stats_totals;
+
+static const char* timer_names[STATS_TIMERS] = {
+	"rotate_ns", "project_ns", "depth_ns", "output_ns",
+};
+static const char* counter_names[STATS_COUNTERS] = {
+	"points", "offscreen", "rejected", "bytes",
+};
+
+/* Copies the totals the render threads may be adding to */
+static StatsTotals stats_snapshot(void) {
+	StatsTotals t;
+	for (int i = 0; i < STATS_TIMERS; i++)
+		t.ns[i] = __atomic_load_n(&stats_totals.ns[i], __ATOMIC_RELAXED);
+	for (int i = 0; i < STATS_COUNTERS; i++)
+		t.count[i] = __atomic_load_n(&stats_totals.count[i], __ATOMIC_RELAXED);
+	return t;
+}
+
+/*
+ * Starts the first window and opens the log at path, which may be NULL
+ * for the overlay alone. Returns 0 if the log can't be created.
+ */
+int stats_open(StatsLog* l, const char* path, int json) {
+	memset(l, 0, sizeof(*l));
+	l->json = json;
+	l->period_ns = STATS_PERIOD_NS;
+	l->start_ns = l->window_ns = stats_now();
+	l->last = stats_snapshot();
+	strcpy(l->line, "stats: first second...");
+
+	if (!path) return 1;
+	l->log = fopen(path, "w");
+	if (!l->log)
+	{
+		perror(path);
+		return 0;
+	}
+	if (!json)
+	{
+		fprintf(l->log, "time_s,frames,fps");
+		for (int i = 0; i < STATS_TIMERS; i++)
+			fprintf(l->log, ",%s", timer_names[i]);
+		for (int i = 0; i < STATS_COUNTERS; i++)
+			fprintf(l->log, ",%s", counter_names[i]);
+		fprintf(l->log, "\n");
+	}
+	return 1;
+}
+
+void stats_close(StatsLog* l) {
+	if (l->log) fclose(l->log);
+	l->log = NULL;
+}
+
+/* Writes the window's averages per frame as one log line */
+static void stats_write(StatsLog* l, double time_s, double fps,
+						const double* ns, const double* count) {
+	if (l->json)
+	{
+		fprintf(l->log, "{\"time_s\": %.3f, \"frames\": %ld, \"fps\": %.1f",
+				time_s, l->frames, fps);
+		for (int i = 0; i < STATS_TIMERS; i++)
+			fprintf(l->log, ", \"%s\": %.0f", timer_names[i], ns[i]);
+		for (int i = 0; i < STATS_COUNTERS; i++)
+			fprintf(l->log, ", \"%s\": %.0f", counter_names[i], count[i]);
+		fprintf(l->log, "}\n");
+	}
+	else
+	{
+		fprintf(l->log, "%.3f,%ld,%.1f", time_s, l->frames, fps);
+		for (int i = 0; i < STATS_TIMERS; i++) fprintf(l->log, ",%.0f", ns[i]);
+		for (int i = 0; i < STATS_COUNTERS; i++)
+			fprintf(l->log, ",%.0f", count[i]);
+		fprintf(l->log, "\n");
+	}
+	fflush(l->log);
+}
+
+/*
+ * Counts a finished frame. Once the window is a period long, logs and
+ * shows its averages and starts the next one. Only this, once a second,
+ * formats anything: the frames in between add to the totals alone.
+ */
+void stats_frame(StatsLog* l) {
+	l->frames++;
+	long long now = stats_now();
+	if (now - l->window_ns < l->period_ns) return;
+
+	StatsTotals t = stats_snapshot();
+	double ns[STATS_TIMERS], count[STATS_COUNTERS];
+	for (int i = 0; i < STATS_TIMERS; i++)
+		ns[i] = (double) (t.ns[i] - l->last.ns[i]) / l->frames;
+	for (int i = 0; i < STATS_COUNTERS; i++)
+		count[i] = (double) (t.count[i] - l->last.count[i]) / l->frames;
+	double fps = l->frames * 1e9 / (now - l->window_ns);
+
+	if (l->log)
+		stats_write(l, (now - l->start_ns) * 1e-9, fps, ns, count);
+
+	snprintf(l->line, sizeof(l->line),
+			 "%.0f fps | rotate %.1f project %.1f depth %.1f output %.1f us | "
+			 "%.0f points, %.0f off, %.0f rejected | %.1f KB",
+			 fps, ns[STATS_ROTATE] * 1e-3, ns[STATS_PROJECT] * 1e-3,
+			 ns[STATS_DEPTH] * 1e-3, ns[STATS_OUTPUT] * 1e-3,
+			 count[STATS_POINTS], count[STATS_OFFSCREEN],
+			 count[STATS_REJECTED], count[STATS_BYTES] / 1024);
+
+	l->last = t;
+	l->window_ns = now;
+	l->frames = 0;
+}
+
+/* Writes the last window's line over the top row of a frame */
+void stats_overlay(const StatsLog* l, char* cells, int width) {
+	int n = (int) strlen(l->line);
+	if (n > width) n = width;
+	memcpy(cells, l->line, n);
+	memset(cells + n, ' ', width - n);
+}
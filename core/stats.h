@@ -0,0 +1,95 @@
+// stats.h
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Hot-path instrumentation, built in with make STATS=1 (SPIN_STATS).
+ * Without it every STATS_ macro expands to nothing, so the renderer pays
+ * nothing for it. The totals are process-wide, like the allocation count,
+ * and updated with relaxed atomics once per chunk or triangle, so the
+ * render threads can share them.
+ */
+#ifdef SPIN_STATS
+#define STATS_ENABLED 1
+#else
+#define STATS_ENABLED 0
+#endif
+
+/* Timed stages, summed over every thread that runs them */
+typedef enum {
+	STATS_ROTATE,  // compose the matrices, pick densities, cull
+	STATS_PROJECT, // project points or mesh vertices
+	STATS_DEPTH,   // depth test points or fill triangles
+	STATS_OUTPUT,  // assemble and send frames
+	STATS_TIMERS
+} StatsTimer;
+
+/* Counted events */
+typedef enum {
+	STATS_POINTS,	 // points or vertices projected
+	STATS_OFFSCREEN, // of those, off the frame or behind the camera
+	STATS_REJECTED,	 // points or cells that lost the depth test
+	STATS_BYTES,	 // bytes written to the output
+	STATS_COUNTERS
+} StatsCounter;
+
+/* Structures */
+
+typedef struct {
+	unsigned long long ns[STATS_TIMERS];
+	unsigned long long count[STATS_COUNTERS];
+} StatsTotals;
+
+/* The overlay line, and the longest one the log holds for it */
+#define STATS_LINE_MAX 160
+
+/*
+ * Periodic report of the totals: every period, the averages per frame of
+ * the window that just ended go to the log as a CSV or JSON line and
+ * replace the overlay line.
+ */
+typedef struct {
+	FILE* log; // NULL for none
+	int json;  // one JSON object per line instead of CSV rows
+	long long period_ns;
+	long long start_ns, window_ns; // run and current window start
+	StatsTotals last;			   // totals at the window start
+	long frames;				   // in the current window
+	char line[STATS_LINE_MAX];
+} StatsLog;
+
+extern StatsTotals stats_totals;
+
+/* Monotonic time in nanoseconds */
+static inline long long stats_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+#ifdef SPIN_STATS
+#define STATS_ONLY(...) __VA_ARGS__
+#define STATS_BEGIN(t) long long t = stats_now()
+#define STATS_END(t, timer)                                            \
+	__atomic_fetch_add(&stats_totals.ns[timer], stats_now() - (t),     \
+					   __ATOMIC_RELAXED)
+#define STATS_ADD(counter, n)                                          \
+	__atomic_fetch_add(&stats_totals.count[counter], (n), __ATOMIC_RELAXED)
+#else
+#define STATS_ONLY(...)
+#define STATS_BEGIN(t)
+#define STATS_END(t, timer) ((void) 0)
+#define STATS_ADD(counter, n) ((void) 0)
+#endif
+
+/* Function Prototypes */
+int stats_open(StatsLog* l, const char* path, int json);
+void stats_close(StatsLog* l);
+void stats_frame(StatsLog* l);
+void stats_overlay(const StatsLog* l, char* cells, int width);
+
+#endif
@@ -0,0 +1,64 @@
+// term.c
+
+#include "core/term.h"
+
+#include <signal.h>
+#ifndef _WIN32
+#include <sys/ioctl.h>
+#endif
+
+static volatile sig_atomic_t resized = 0;
+static volatile sig_atomic_t interrupted = 0;
+
+/*
+ * Replaces width and height with the size of the terminal on fd, leaving
+ * them untouched when fd is not a terminal. The last row is kept free for
+ * the cursor, so the frame never scrolls the screen.
+ */
+void term_size(int fd, int* width, int* height) {
+#ifdef TIOCGWINSZ
+	struct winsize ws;
+	if (fd >= 0 && ioctl(fd, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 &&
+		ws.ws_row > 1)
+	{
+		*width = ws.ws_col;
+		*height = ws.ws_row - 1;
+	}
+#else
+	(void) fd;
+	(void) width;
+	(void) height;
+#endif
+}
+
+#ifdef SIGWINCH
+static void handle_sigwinch(int sig) {
+	(void) sig;
+	resized = 1;
+}
+#endif
+
+/* Starts flagging terminal size changes for term_resized */
+void term_watch_resize(void) {
+#ifdef SIGWINCH
+	signal(SIGWINCH, handle_sigwinch);
+#endif
+}
+
+/* Returns 1 once per batch of size changes since the last call */
+int term_resized(void) {
+	if (!resized) return 0;
+	resized = 0;
+	return 1;
+}
+
+static void handle_sigint(int sig) {
+	(void) sig;
+	interrupted = 1;
+}
+
+/* Turns Ctrl+C into a flag for term_interrupted, so a loop can end cleanly */
+void term_watch_interrupt(void) { signal(SIGINT, handle_sigint); }
+
+/* Returns 1 once Ctrl+C has been pressed */
+int term_interrupted(void) { return interrupted; }
@@ -0,0 +1,13 @@
+// term.h
+
+#ifndef TERM_H
+#define TERM_H
+
+/* Function Prototypes */
+void term_size(int fd, int* width, int* height);
+void term_watch_resize(void);
+int term_resized(void);
+void term_watch_interrupt(void);
+int term_interrupted(void);
+
+#endif
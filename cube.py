@@ -2,6 +2,10 @@
 Specification in Python.
 """
 
+import ctypes
+import sys
+import time
+
 import numpy as np
 
 WIDTH, HEIGHT = 170, 44
@@ -148,6 +152,56 @@ def main():
         B += 1e-4
         C += 1e-4
 
+def load_native(path="build/double/libspin.so"):
+    lib = ctypes.CDLL(path)
+    lib.spin_new.restype = ctypes.c_void_p
+    lib.spin_new.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int]
+    lib.spin_delete.argtypes = [ctypes.c_void_p]
+    lib.spin_set_view.argtypes = [ctypes.c_void_p] + [ctypes.c_double] * 3
+    lib.spin_set_triangles.argtypes = [
+        ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int,
+        ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int,
+    ]
+    lib.spin_orient_outward.argtypes = [ctypes.c_void_p]
+    lib.spin_set_angles.argtypes = [ctypes.c_void_p] + [ctypes.c_double] * 3
+    lib.spin_render.argtypes = [ctypes.c_void_p] * 3
+    return lib
+
+def main_native():
+    """
+    The same cube through the C renderer (make lib). Frames are drawn in
+    place into numpy buffers, so nothing is copied per frame.
+    """
+    lib = load_native()
+    view = lib.spin_new(1, WIDTH, HEIGHT)
+    lib.spin_set_view(view, Near_dst, Far_dst, Cube_dst)
+
+    verts = np.ascontiguousarray(vertices, dtype=np.float64)
+    tris = np.array(
+        [[f[0], f[1], f[2]] for f in faces] + [[f[0], f[2], f[3]] for f in faces],
+        dtype=np.int32,
+    )
+    chars = "".join(face_chars * 2).encode()
+    lib.spin_set_triangles(view, verts.ctypes.data, len(verts),
+                           tris.ctypes.data, chars, len(tris))
+    # The faces list is wound either way; the cube is convex
+    lib.spin_orient_outward(view)
+
+    screen = np.full((HEIGHT, WIDTH), ord(" "), np.uint8)
+    # float32 or int32 (16.16) for a library built with PRECISION=float|fixed
+    depth = np.full((HEIGHT, WIDTH), Far_dst, np.float64)
+    A = B = C = 0.0
+
+    try:
+        while True:
+            lib.spin_set_angles(view, A, B, C)
+            lib.spin_render(view, screen.ctypes.data, depth.ctypes.data)
+            print("\033[H" + "\n".join(row.tobytes().decode() for row in screen))
+            A, B, C = A + 0.04, B + 0.04, C + 0.04
+            time.sleep(0.08)
+    finally:
+        lib.spin_delete(view)
+
 if __name__ == "__main__":
-    main()
+    main_native() if "--native" in sys.argv else main()
 
@@ -0,0 +1,63 @@
+// model.c
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "core/app.h"
+#include "core/linalg.h"
+#include "core/mesh.h"
+#include "core/meshio.h"
+#include "core/options.h"
+#include "core/spin.h"
+
+/* Definitions and Constants */
+const double near_dst = 40.0f;
+const double far_dst = 120.0f;
+const double model_dst = 75.0f;
+const double model_radius = 30.0f; // about the cube's half diagonal
+
+/* Characters for faces turned towards +x, -x, +y, -y, +z, -z */
+const char face_chars[] = {'@', '#', '$', '?', '+', ':'};
+
+/* Function Prototypes */
+int setup_model(Spin* s, void* user);
+
+/* Main Function */
+int main(int argc, char** argv) {
+	Options opts;
+	if (!options_parse(&opts, argc, argv)) return 1;
+
+	if (!opts.mesh_path)
+	{
+		fprintf(stderr, "Usage: %s --mesh FILE [options]\n", argv[0]);
+		return 1;
+	}
+	if (opts.raster == RASTER_POINTS)
+	{
+		fprintf(stderr, "Meshes are only drawn with --raster faces\n");
+		return 1;
+	}
+
+	/* Turns like the cube */
+	AppScene scene = {{0.5, 0.5, 0.5}, setup_model, NULL, &opts};
+	return app_main(&opts, &scene);
+}
+
+/* Loads the mesh and places it where the cube would be */
+int setup_model(Spin* s, void* user) {
+	const Options* opts = user;
+	Vec3 center_point = {0, 0, model_dst};
+	Vec3 cam_point = {0, 0, 0};
+	spin_set_camera(s, near_dst, far_dst, cam_point, center_point);
+
+	Mesh mesh;
+	if (!mesh_load(&mesh, opts->mesh_path, opts->mesh_cache)) return 0;
+	mesh_fit(&mesh, center_point, model_radius);
+	mesh_shade_by_normal(&mesh, face_chars);
+	if (!spin_set_mesh(s, &mesh))
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 0;
+	}
+	return 1;
+}
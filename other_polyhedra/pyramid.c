@@ -1,28 +1,32 @@
 // pyram.c
 
-#include <math.h>
 #include <signal.h> // for Ctrl+C
 #include <stdio.h>
 #include <stdlib.h>
-#include <strings.h>
-#include <unistd.h> // for usleep()
+
+#include "core/app.h"
+#include "core/linalg.h"
+#include "core/mesh.h"
+#include "core/options.h"
+#include "core/points.h"
+#include "core/render.h"
+#include "core/spin.h"
 
 /* Definitions and Constants */
-#define WIDTH 170
-#define HEIGHT 40
+#define BASE_POINTS 50 // points per face edge at the layout size
 #define PYRAM_TRIANG_FACES 4 // there's 4 triangular faces and 1 square.
 #define PYRAM_VETICES 5
-#define PI 3.14159
 
 /* Structures */
-typedef struct {
-	double x, y, z;
-} Point;
+typedef Vec3 Point;
 
+/* The pyramid in world space, shared by the setup and fit callbacks */
 typedef struct {
-	double* data;
-	int rows, cols;
-} Matrix;
+	Point vertices[PYRAM_VETICES];
+	int triangular_faces[PYRAM_TRIANG_FACES][3];
+	int base_face[4];
+	FacePlane planes[PYRAM_TRIANG_FACES + 1];
+} Pyramid;
 
 const double near_dst = 40.0f;
 const double far_dst = 220.0f;
@@ -31,329 +35,139 @@ const double pyram_width = 50.0f;
 const double pyram_edge = 2.0f * pyram_width;
 const double pyram_height = 1.15f * pyram_width;
 
-int num_points = 50;
-int total_points = 7600;
-
-/* Buffers for screen display */
-char face_chars[] = {'@', '#', '$', '?', '+'};
-double z_buff[HEIGHT][WIDTH];
-char screen_buffer[HEIGHT][WIDTH];
-Point* pyram_points;
+const char face_chars[] = {'@', '#', '$', '?', '+'};
 
 /* Function Prototypes */
 void handle_sigint(int sig);
-void reset_buffs(void);
-char get_char(int point_idx);
-double mod(double a, double b);
-Point* project_xyz(Point* p, Point* center_point);
-Point* rotate_XYZ(Point* p, Point* center, double theta_x, double theta_y,
-				  double theta_z);
-void translate_xyz(Point* p, double tx, double ty, double tz);
-Point* generate_points(Point* vertices, int triang_faces[PYRAM_TRIANG_FACES][3],
-					   int base_fase[4], int num_points);
-void free_matrix(Matrix* m);
-Matrix* new_matrix(int rows, int cols);
-Matrix* mat_mul(Matrix* a, Matrix* b);
-Matrix* rotate_X(double theta_x);
-Matrix* rotate_Y(double theta_y);
-Matrix* rotate_Z(double theta_z);
+int setup_pyramid(Spin* s, void* user);
+int fit_pyramid(Spin* s, void* user);
+int sample_pyramid_face(PointsSoA* points, int first, int face,
+						int num_points, void* user);
 
 /* Main Function */
-int main(void) {
+int main(int argc, char** argv) {
+	Options opts;
+	if (!options_parse(&opts, argc, argv)) return 1;
+
 	signal(SIGINT, handle_sigint); // Register the signal handler for SIGINT
-	reset_buffs();
 
 	/* Define the pyram vertices */
-	Point vertices[PYRAM_VETICES] = {
-		{-pyram_width / 2, pyram_height / 2, -pyram_width / 2},
-		{pyram_width / 2, pyram_height / 2, -pyram_width / 2},
-		{pyram_width / 2, pyram_height / 2, pyram_width / 2},
-		{-pyram_width / 2, pyram_height / 2, pyram_width / 2},
-		{0, -pyram_height / 2, 0}};
-
-	/* Translate the pyram away from the camera */
-	Point center_point = {0, 0, pyram_dst};
-	Point cam_point = {0, 0, 0};
-
-	for (int i = 0; i < PYRAM_VETICES; i++) vertices[i].z += pyram_dst;
-
-	/* Define the pyram faces (vertex indices) */
-	int triangular_faces[PYRAM_TRIANG_FACES][3] = {
-		{0, 1, 4},
-		{1, 2, 4},
-		{2, 3, 4},
-		{3, 0, 4},
+	Pyramid pyramid = {
+		.vertices = {{-pyram_width / 2, pyram_height / 2, -pyram_width / 2},
+					 {pyram_width / 2, pyram_height / 2, -pyram_width / 2},
+					 {pyram_width / 2, pyram_height / 2, pyram_width / 2},
+					 {-pyram_width / 2, pyram_height / 2, pyram_width / 2},
+					 {0, -pyram_height / 2, 0}},
+
+		/* Define the pyram faces (vertex indices) */
+		.triangular_faces = {
+			{0, 1, 4},
+			{1, 2, 4},
+			{2, 3, 4},
+			{3, 0, 4},
+		},
+
+		.base_face = {0, 1, 2, 3},
 	};
 
-	int base_face[4] = {0, 1, 2, 3};
-
-	pyram_points =
-		generate_points(vertices, triangular_faces, base_face, num_points);
-
-	/* Initial rotation angles */
-	double A = 0, B = 0, C = 0;
-
-	/* Main animation loop */
-	while (1)
-	{
-		/* Rotate each pyram point */
-		for (int i = 0; i < total_points; i++)
-		{
-			Point* rotated =
-				rotate_XYZ(&pyram_points[i], &center_point, A, B, C);
-			pyram_points[i] = *rotated;
-			free(rotated);
-		}
-
-		/* Clear the screen and reset buffers */
-		printf("\033[2J");
-		reset_buffs();
-
-		/* Project points and update depth and screen buffers */
-		for (int i = 0; i < total_points; i++)
-		{
-			/* Map projected coordinates to screen indices */
-			Point* proj = project_xyz(&pyram_points[i], &cam_point);
-
-			int screen_x = (int) (proj->x) + WIDTH / 2;
-			int screen_y = (int) (proj->y) + HEIGHT / 2;
-
-			if (screen_x >= 0 && screen_x < WIDTH && screen_y >= 0 &&
-				screen_y < HEIGHT)
-			{
-				/* Update if the point is closer (smaller z value) */
-				if (proj->z < z_buff[screen_y][screen_x])
-				{
-					z_buff[screen_y][screen_x] = proj->z;
-					screen_buffer[screen_y][screen_x] = get_char(i);
-				}
-			}
-			free(proj);
-		}
-
-		/* Display the screen buffer */
-		for (int i = 0; i < HEIGHT; i++)
-		{
-			for (int j = 0; j < WIDTH; j++) putchar(screen_buffer[i][j]);
-			putchar('\n');
-		}
-
-		/* Increment rotation angles */
-		double inc = 0.001;
-
-		/* Increment angles avoiding precision overflow */
-		/*A = mod(A + inc, 2 * PI);*/
-		B = mod(B + inc, 2 * PI);
-		/*C = mod(C + inc, 2 * PI);*/
-
-		usleep(80000);
-	}
-
-	free(pyram_points);
-
-	return 0;
+	/* Turns about the vertical axis only */
+	AppScene scene = {{0, 0.5, 0}, setup_pyramid, fit_pyramid, &pyramid};
+	return app_main(&opts, &scene);
 }
 
 
 void handle_sigint(int sig) {
 	printf("\nExiting...\n");
 
-	free(pyram_points);
-
 	exit(0);
 }
 
-/* Returns a character based on the point index */
-char get_char(int point_idx) {
-	int num_chars = sizeof(face_chars) / sizeof(char);
+/* Places the pyram in front of the camera and builds its faces */
+int setup_pyramid(Spin* s, void* user) {
+	Pyramid* pyr = user;
+	Point* vertices = pyr->vertices;
 
-	if (point_idx < 1275)
-	{
-		return face_chars[0];
-	} else if (point_idx < 1275 * 2)
-	{
-		return face_chars[1];
-	} else if (point_idx < 1275 * 3)
-	{
-		return face_chars[2];
-	} else if (point_idx < 1275 * 4)
-		return face_chars[3];
+	/* Translate the pyram away from the camera */
+	Point center_point = {0, 0, pyram_dst};
+	Point cam_point = {0, 0, 0};
 
-	return face_chars[4];
-}
+	for (int i = 0; i < PYRAM_VETICES; i++) vertices[i].z += pyram_dst;
+	spin_set_camera(s, near_dst, far_dst, cam_point, center_point);
 
-/* Resets the depth and screen buffers */
-void reset_buffs(void) {
-	for (int i = 0; i < HEIGHT; i++)
+	/* Indexed faces for the rasterizer, the base is two triangles */
+	Mesh mesh;
+	if (!mesh_init(&mesh, PYRAM_VETICES, PYRAM_TRIANG_FACES + 2))
 	{
-		for (int j = 0; j < WIDTH; j++)
-		{
-			z_buff[i][j] = far_dst;
-			screen_buffer[i][j] = ' ';
-		}
+		fprintf(stderr, "Out of memory\n");
+		return 0;
 	}
-}
-
-/* Computes the modulus operator between two numbers */
-double mod(double a, double b) { return a - b * (int) (a / b); }
-
-/* Creates and returns a new matrix with given dimensions */
-Matrix* new_matrix(int rows, int cols) {
-	Matrix* m = malloc(sizeof(Matrix));
-
-	m->rows = rows;
-	m->cols = cols;
-	m->data = calloc(rows * cols, sizeof(double));
-
-	return m;
-}
-
-/* Frees the memory used by a matrix */
-void free_matrix(Matrix* m) {
-	if (m)
+	for (int i = 0; i < PYRAM_VETICES; i++) mesh.verts[i] = vertices[i];
+	for (int f = 0; f < PYRAM_TRIANG_FACES; f++)
 	{
-		free(m->data);
-		free(m);
+		Triangle tri = {{pyr->triangular_faces[f][0],
+						 pyr->triangular_faces[f][1],
+						 pyr->triangular_faces[f][2]},
+						face_chars[f]};
+		mesh.tris[f] = tri;
 	}
-}
-
-/* Matrix multiplication: result = a * b */
-Matrix* mat_mul(Matrix* a, Matrix* b) {
-	if (a->cols != b->rows) return NULL;
-	Matrix* r = new_matrix(a->rows, b->cols);
-	for (int i = 0; i < a->rows; i++)
+	mesh_set_quad(&mesh, PYRAM_TRIANG_FACES, pyr->base_face,
+				  face_chars[PYRAM_TRIANG_FACES]);
+	mesh_orient_outward(&mesh, center_point);
+	if (!spin_set_mesh(s, &mesh))
 	{
-		for (int j = 0; j < b->cols; j++)
-		{
-			double sum = 0;
-			for (int k = 0; k < a->cols; k++)
-				sum += a->data[i * a->cols + k] * b->data[k * b->cols + j];
-			r->data[i * r->cols + j] = sum;
-		}
+		fprintf(stderr, "Out of memory\n");
+		return 0;
 	}
-	return r;
-}
-
-/* Rotation around the X axis */
-Matrix* rotate_X(double theta) {
-	Matrix* R = new_matrix(3, 3);
-
-	double c = cos(theta), s = sin(theta);
-
-	R->data[0] = 1;
-	R->data[1] = 0;
-	R->data[2] = 0;
-
-	R->data[3] = 0;
-	R->data[4] = c;
-	R->data[5] = -s;
-
-	R->data[6] = 0;
-	R->data[7] = s;
-	R->data[8] = c;
-
-	return R;
-}
-
-/* Rotation around the Y axis */
-Matrix* rotate_Y(double theta) {
-	Matrix* R = new_matrix(3, 3);
-
-	double c = cos(theta), s = sin(theta);
-
-	R->data[0] = c;
-	R->data[1] = 0;
-	R->data[2] = s;
 
-	R->data[3] = 0;
-	R->data[4] = 1;
-	R->data[5] = 0;
-
-	R->data[6] = -s;
-	R->data[7] = 0;
-	R->data[8] = c;
-
-	return R;
-}
-
-/* Rotation around the Z axis */
-Matrix* rotate_Z(double theta) {
-	Matrix* R = new_matrix(3, 3);
-
-	double c = cos(theta), s = sin(theta);
-
-	R->data[0] = c;
-	R->data[1] = -s;
-	R->data[2] = 0;
-
-	R->data[3] = s;
-	R->data[4] = c;
-	R->data[5] = 0;
-
-	R->data[6] = 0;
-	R->data[7] = 0;
-	R->data[8] = 1;
-
-	return R;
+	/* Face planes for the point path's visibility and level of detail */
+	Point corners[4];
+	for (int f = 0; f < PYRAM_TRIANG_FACES; f++)
+	{
+		for (int k = 0; k < 3; k++)
+			corners[k] = vertices[pyr->triangular_faces[f][k]];
+		pyr->planes[f] = face_polygon(corners, 3, center_point);
+	}
+	for (int k = 0; k < 4; k++) corners[k] = vertices[pyr->base_face[k]];
+	pyr->planes[PYRAM_TRIANG_FACES] = face_polygon(corners, 4, center_point);
+	return 1;
 }
 
-/* Applies full rotation (X, Y, Z) to a point relative to a center */
-Point* rotate_XYZ(Point* p, Point* center, double theta_x, double theta_y,
-				  double theta_z) {
-	double rx = p->x - center->x;
-	double ry = p->y - center->y;
-	double rz = p->z - center->z;
-
-	Matrix* vec = new_matrix(3, 1);
+/* Resamples the face points for the context's current scale */
+int fit_pyramid(Spin* s, void* user) {
+	Pyramid* pyr = user;
 
-	vec->data[0] = rx;
-	vec->data[1] = ry;
-	vec->data[2] = rz;
-
-	Matrix* Rx = rotate_X(theta_x);
-	Matrix* Ry = rotate_Y(theta_y);
-	Matrix* Rz = rotate_Z(theta_z);
-
-	Matrix* RyRz = mat_mul(Ry, Rz);
-	Matrix* R = mat_mul(Rx, RyRz);
-	Matrix* result = mat_mul(R, vec);
-
-	Point* rotated = (Point*) malloc(sizeof(Point));
-
-	rotated->x = result->data[0] + center->x;
-	rotated->y = result->data[1] + center->y;
-	rotated->z = result->data[2] + center->z;
-
-	free_matrix(Rx);
-	free_matrix(Ry);
-	free_matrix(Rz);
-	free_matrix(RyRz);
-	free_matrix(R);
-	free_matrix(vec);
-	free_matrix(result);
-
-	return rotated;
-}
-
-/* Translates a point in space */
-void translate_xyz(Point* p, double tx, double ty, double tz) {
-	p->x += tx;
-	p->y += ty;
-	p->z += tz;
+	PointsSoA points = {0};
+	PointSpan spans[SPIN_LOD_LEVELS * (PYRAM_TRIANG_FACES + 1)];
+	if (!spin_sample_faces(&points, spans, PYRAM_TRIANG_FACES + 1, face_chars,
+						   BASE_POINTS * s->scale, sample_pyramid_face, pyr) ||
+		!spin_set_points(s, &points, spans, pyr->planes,
+						 PYRAM_TRIANG_FACES + 1, SPIN_LOD_LEVELS))
+	{
+		points_free(&points);
+		fprintf(stderr, "Out of memory\n");
+		return 0;
+	}
+	return 1;
 }
 
-/* Generates points for the pyram faces using interpolation */
-Point* generate_points(Point* vertices, int triang_faces[PYRAM_TRIANG_FACES][3],
-					   int base_face[4], int num_points) {
-	Point* points = malloc(sizeof(Point) * total_points);
-	int point_idx = 0;
+/*
+ * Samples a face of the pyramid by interpolating its corners, num_points
+ * rows of a triangle or a num_points x num_points grid on the base, for
+ * spin_sample_faces
+ */
+int sample_pyramid_face(PointsSoA* points, int first, int face,
+						int num_points, void* user) {
+	Pyramid* pyr = user;
+	int point_idx = first;
 
 	// Triangular faces
-	for (int f = 0; f < PYRAM_TRIANG_FACES; f++)
+	if (face < PYRAM_TRIANG_FACES)
 	{
-		Point v0 = vertices[triang_faces[f][0]];
-		Point v1 = vertices[triang_faces[f][1]];
-		Point v2 = vertices[triang_faces[f][2]];
+		if (!points) return first + num_points * (num_points + 1) / 2;
+
+		Point v0 = pyr->vertices[pyr->triangular_faces[face][0]];
+		Point v1 = pyr->vertices[pyr->triangular_faces[face][1]];
+		Point v2 = pyr->vertices[pyr->triangular_faces[face][2]];
 
 		for (int i = 0; i < num_points; i++)
 		{
@@ -363,20 +177,23 @@ Point* generate_points(Point* vertices, int triang_faces[PYRAM_TRIANG_FACES][3],
 				double b = (double) j / num_points;
 				double c = 1.0 - a - b;
 
-				points[point_idx].x = a * v0.x + b * v1.x + c * v2.x;
-				points[point_idx].y = a * v0.y + b * v1.y + c * v2.y;
-				points[point_idx].z = a * v0.z + b * v1.z + c * v2.z;
+				Point p = {a * v0.x + b * v1.x + c * v2.x,
+						   a * v0.y + b * v1.y + c * v2.y,
+						   a * v0.z + b * v1.z + c * v2.z};
 
-				point_idx++;
+				points_set(points, point_idx++, p);
 			}
 		}
+		return point_idx;
 	}
 
 	// Base face
-	Point v0 = vertices[base_face[0]];
-	Point v1 = vertices[base_face[1]];
-	Point v2 = vertices[base_face[2]];
-	Point v3 = vertices[base_face[3]];
+	if (!points) return first + num_points * num_points;
+
+	Point v0 = pyr->vertices[pyr->base_face[0]];
+	Point v1 = pyr->vertices[pyr->base_face[1]];
+	Point v2 = pyr->vertices[pyr->base_face[2]];
+	Point v3 = pyr->vertices[pyr->base_face[3]];
 
 	for (int i = 0; i < num_points; i++)
 	{
@@ -390,63 +207,12 @@ Point* generate_points(Point* vertices, int triang_faces[PYRAM_TRIANG_FACES][3],
 			Point p2 = {v3.x + a * (v2.x - v3.x), v3.y + a * (v2.y - v3.y),
 						v3.z + a * (v2.z - v3.z)};
 
-			points[point_idx].x = p1.x + b * (p2.x - p1.x);
-			points[point_idx].y = p1.y + b * (p2.y - p1.y);
-			points[point_idx].z = p1.z + b * (p2.z - p1.z);
+			Point p = {p1.x + b * (p2.x - p1.x), p1.y + b * (p2.y - p1.y),
+					   p1.z + b * (p2.z - p1.z)};
 
-			point_idx++;
+			points_set(points, point_idx++, p);
 		}
 	}
 
-	return points;
-}
-
-/* Projects a point using homogeneous coordinates */
-Point* project_xyz(Point* p, Point* center_point) {
-	/* Create a homogeneous vector: (x - cx, y - cy, z - cz, 1) */
-	double vec[4] = {p->x - center_point->x, p->y - center_point->y,
-					 p->z - center_point->z, 1.0};
-
-	Matrix* vec_m = new_matrix(4, 1);
-
-	for (int i = 0; i < 4; i++) vec_m->data[i] = vec[i];
-
-	/* Define the projection matrix */
-	Matrix* proj = new_matrix(4, 4);
-
-	proj->data[0] = near_dst;
-	proj->data[1] = 0;
-	proj->data[2] = 0;
-	proj->data[3] = 0;
-
-	proj->data[4] = 0;
-	proj->data[5] = near_dst;
-	proj->data[6] = 0;
-	proj->data[7] = 0;
-
-	proj->data[8] = 0;
-	proj->data[9] = 0;
-	proj->data[10] = far_dst + near_dst;
-	proj->data[11] = -far_dst * near_dst;
-
-	proj->data[12] = 0;
-	proj->data[13] = 0;
-	proj->data[14] = 1;
-	proj->data[15] = 0;
-
-	Matrix* result = mat_mul(proj, vec_m);
-	double w = result->data[3];
-
-	/* Dehomogenize to get the projected point */
-	Point* projected = malloc(sizeof(Point));
-
-	projected->x = result->data[0] / w;
-	projected->y = result->data[1] / w;
-	projected->z = result->data[2] / w;
-
-	free_matrix(vec_m);
-	free_matrix(proj);
-	free_matrix(result);
-
-	return projected;
+	return point_idx;
 }
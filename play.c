@@ -0,0 +1,143 @@
+// play.c
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "core/alloc.h"
+#include "core/bench.h"
+#include "core/options.h"
+#include "core/present.h"
+#include "core/record.h"
+#include "core/sched.h"
+#include "core/term.h"
+
+/*
+ * Plays a recording made with --record: frames are decoded from the
+ * mapped file and shown at their recorded ticks, with no 3D math at all.
+ */
+
+/*
+ * Makes start the next frame to decode. Deltas apply to the frame before,
+ * so that one is decoded into cells, from the keyframe before it.
+ */
+static int play_from(Replay* replay, int start, char* cells) {
+	unsigned long long tick;
+	if (start == 0)
+	{
+		replay->next = 0;
+		return 1;
+	}
+	return replay_seek(replay, start - 1, cells, &tick);
+}
+
+/* Main Function */
+int main(int argc, char** argv) {
+	Options opts;
+	if (!options_parse(&opts, argc, argv)) return 1;
+
+	if (!opts.replay_path)
+	{
+		fprintf(stderr, "Usage: %s --replay FILE [options]\n", argv[0]);
+		return 1;
+	}
+
+	Replay replay;
+	if (!replay_open(&replay, opts.replay_path)) return 1;
+	if (replay.num_frames <= opts.replay_from)
+	{
+		fprintf(stderr, "%s: %d frames, none from frame %d\n",
+				opts.replay_path, replay.num_frames, opts.replay_from);
+		return 1;
+	}
+
+	/* Frames keep the recorded size */
+	int out_fd = options_output_fd(&opts);
+	char* cells = mem_alloc(replay.width * replay.height);
+
+	Presenter presenter;
+	Bench bench;
+	if (!cells ||
+		!presenter_init(&presenter, out_fd, replay.width, replay.height,
+						opts.present, opts.async_present) ||
+		!bench_init(&bench, opts.bench))
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	/* The scheduler runs at the recorded tick period */
+	Scheduler sched;
+	sched_init(&sched, 1e9 / replay.period_ns, opts.sched);
+	unsigned long long first_tick = 0;
+	int failed = !play_from(&replay, opts.replay_from, cells);
+
+	term_watch_resize();
+	term_watch_interrupt();
+	while (!failed && !term_interrupted())
+	{
+		/* Frames keep their size, but the terminal may have reflowed */
+		if (term_resized()) presenter_invalidate(&presenter);
+
+		/* Start over at the end, on a fresh clock */
+		if (replay.next == replay.num_frames)
+		{
+			if (!opts.loop) break;
+			if (!play_from(&replay, opts.replay_from, cells))
+			{
+				failed = 1;
+				break;
+			}
+			sched_init(&sched, 1e9 / replay.period_ns, opts.sched);
+		}
+
+		/* Sleep until the frame's recorded tick */
+		unsigned long long tick;
+		if (!replay_tick(&replay, replay.next, &tick))
+		{
+			failed = 1;
+			break;
+		}
+		if (replay.next == opts.replay_from) first_tick = tick;
+		if (!opts.bench) sched_wait_tick(&sched, tick - first_tick);
+
+		size_t frame_allocs = mem_alloc_count();
+		bench_begin(&bench);
+
+		/* Decode it over the previous frame */
+		if (!replay_next(&replay, cells, &tick))
+		{
+			failed = 1;
+			break;
+		}
+		bench_lap(&bench, BENCH_RENDER);
+
+		/* Send the frame with a single write */
+		present_frame(&presenter, cells);
+		bench_lap(&bench, BENCH_PRESENT);
+
+		/* The frame must not have touched the heap */
+		bench_allocs(&bench, mem_alloc_count() - frame_allocs);
+		assert(mem_alloc_count() == frame_allocs);
+
+		/* Benchmark mode: no pacing, stop once enough frames are timed */
+		if (opts.bench && bench_end(&bench)) break;
+	}
+	if (failed)
+		fprintf(stderr, "%s: damaged frame %d\n", opts.replay_path,
+				replay.next);
+
+	/* The writer may still hold the last frame */
+	presenter_flush(&presenter);
+	if (opts.bench)
+		bench_report(&bench, stdout, "cells", (long) replay.width * replay.height,
+					 1, presenter_stats(&presenter));
+
+	bench_free(&bench);
+	presenter_free(&presenter);
+	if (opts.sink == SINK_NULL && out_fd >= 0) close(out_fd);
+	mem_free(cells);
+	replay_close(&replay);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,180 @@
+// wall.c
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "core/app.h"
+#include "core/linalg.h"
+#include "core/mesh.h"
+#include "core/meshio.h"
+#include "core/options.h"
+#include "core/scene.h"
+#include "core/spin.h"
+
+/* Definitions and Constants */
+#define DEFAULT_OBJECTS 300
+#define CUBE_FACES 6
+#define CUBE_VERTICES 8
+#define PYRAM_TRIANG_FACES 4
+#define PYRAM_VERTICES 5
+
+const double near_dst = 40.0f;
+const double far_dst = 220.0f;
+const double wall_dst = 100.0f;	  // depth of the front row
+const double wall_spacing = 16.0f; // between neighbouring objects
+const double object_radius = 6.0f;
+
+const char cube_chars[] = {'@', '#', '$', '?', '+', ':'};
+const char pyram_chars[] = {'@', '#', '$', '?', '+'};
+
+/* Characters for mesh faces turned towards +x, -x, +y, -y, +z, -z */
+const char mesh_chars[] = {'@', '#', '$', '?', '+', ':'};
+
+/* Function Prototypes */
+int setup_wall(Spin* s, void* user);
+int add_cube(Scene* sc);
+int add_pyramid(Scene* sc);
+int add_mesh(Scene* sc, const char* path, int cache);
+
+/* Main Function */
+int main(int argc, char** argv) {
+	Options opts;
+	if (!options_parse(&opts, argc, argv)) return 1;
+
+	if (opts.raster == RASTER_POINTS)
+	{
+		fprintf(stderr, "The wall is only drawn with --raster faces\n");
+		return 1;
+	}
+
+	/* Every object turns in place like the cube */
+	AppScene scene = {{0.5, 0.5, 0.5}, setup_wall, NULL, &opts};
+	return app_main(&opts, &scene);
+}
+
+/*
+ * Lays the objects out on a grid wider and taller than the frame, cycling
+ * through the shapes. Objects off the frame cost nothing: they are culled
+ * before projection.
+ */
+int setup_wall(Spin* s, void* user) {
+	const Options* opts = user;
+	int count = opts->objects ? opts->objects : DEFAULT_OBJECTS;
+	spin_set_camera(s, near_dst, far_dst, vec3(0, 0, 0),
+					vec3(0, 0, wall_dst));
+
+	Scene sc;
+	scene_init(&sc);
+	if (!add_cube(&sc) || !add_pyramid(&sc) ||
+		(opts->mesh_path && !add_mesh(&sc, opts->mesh_path, opts->mesh_cache)))
+	{
+		scene_free(&sc);
+		return 0;
+	}
+
+	/* About four times as many columns as rows, like the frame */
+	int rows = (int) (sqrt(count / 4.0) + 0.5);
+	if (rows < 1) rows = 1;
+	int cols = (count + rows - 1) / rows;
+
+	for (int i = 0; i < count; i++)
+	{
+		int row = i / cols, col = i % cols;
+		Vec3 position = {(col - (cols - 1) / 2.0) * wall_spacing,
+						 (row - (rows - 1) / 2.0) * wall_spacing,
+						 wall_dst + (row + col) % 2 * wall_spacing / 2};
+
+		/* A different resting pose for each, so they don't turn in step */
+		Quat rotation = quat_from_euler(i * 0.7, i * 1.3, i * 0.3);
+		if (!scene_add_object(&sc, i % sc.num_shapes, position, object_radius,
+							  rotation))
+		{
+			scene_free(&sc);
+			fprintf(stderr, "Out of memory\n");
+			return 0;
+		}
+	}
+
+	if (!spin_set_objects(s, &sc))
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 0;
+	}
+	return 1;
+}
+
+/* The unit cube, one character per face */
+int add_cube(Scene* sc) {
+	static const Vec3 vertices[CUBE_VERTICES] = {
+		{-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1},
+		{-1, -1, 1},  {1, -1, 1},  {1, 1, 1},  {-1, 1, 1}};
+	static const int faces[CUBE_FACES][4] = {{0, 1, 2, 3}, {4, 5, 6, 7},
+											 {0, 3, 7, 4}, {1, 2, 6, 5},
+											 {0, 1, 5, 4}, {3, 2, 6, 7}};
+	Mesh mesh;
+	if (!mesh_init(&mesh, CUBE_VERTICES, CUBE_FACES * 2))
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 0;
+	}
+	for (int i = 0; i < CUBE_VERTICES; i++) mesh.verts[i] = vertices[i];
+	for (int f = 0; f < CUBE_FACES; f++)
+		mesh_set_quad(&mesh, 2 * f, faces[f], cube_chars[f]);
+	mesh_orient_outward(&mesh, vec3(0, 0, 0));
+
+	if (scene_add_shape(sc, &mesh) < 0)
+	{
+		mesh_free(&mesh);
+		fprintf(stderr, "Out of memory\n");
+		return 0;
+	}
+	return 1;
+}
+
+/* A square pyramid, apex up, one character per face */
+int add_pyramid(Scene* sc) {
+	static const int base[4] = {0, 1, 2, 3};
+	Mesh mesh;
+	if (!mesh_init(&mesh, PYRAM_VERTICES, PYRAM_TRIANG_FACES + 2))
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 0;
+	}
+	mesh.verts[0] = vec3(-1, 0.6, -1);
+	mesh.verts[1] = vec3(1, 0.6, -1);
+	mesh.verts[2] = vec3(1, 0.6, 1);
+	mesh.verts[3] = vec3(-1, 0.6, 1);
+	mesh.verts[4] = vec3(0, -1.4, 0);
+	for (int f = 0; f < PYRAM_TRIANG_FACES; f++)
+	{
+		Triangle tri = {{f, (f + 1) % 4, 4}, pyram_chars[f]};
+		mesh.tris[f] = tri;
+	}
+	mesh_set_quad(&mesh, PYRAM_TRIANG_FACES, base,
+				  pyram_chars[PYRAM_TRIANG_FACES]);
+	mesh_orient_outward(&mesh, vec3(0, 0, 0));
+
+	if (scene_add_shape(sc, &mesh) < 0)
+	{
+		mesh_free(&mesh);
+		fprintf(stderr, "Out of memory\n");
+		return 0;
+	}
+	return 1;
+}
+
+/* A mesh file, shaded by its face normals */
+int add_mesh(Scene* sc, const char* path, int cache) {
+	Mesh mesh;
+	if (!mesh_load(&mesh, path, cache)) return 0;
+	mesh_shade_by_normal(&mesh, mesh_chars);
+
+	if (scene_add_shape(sc, &mesh) < 0)
+	{
+		mesh_free(&mesh);
+		fprintf(stderr, "Out of memory\n");
+		return 0;
+	}
+	return 1;
+}